@@ -0,0 +1,201 @@
+#include "physics/broadphase.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Drives every broadphase mode over canned AABB distributions without a
+// window. Each frame jitters every box slightly, like a settling scene, so
+// the incremental modes see realistic coherence.
+//
+//   bpbench [--frames N] [--dist name] [--mode name] [--cell size] [proxies...]
+
+namespace {
+
+enum class Distribution { Uniform, Clustered, Stacked, LongThin };
+
+const char* distName(Distribution d) {
+  switch (d) {
+    case Distribution::Uniform:   return "uniform";
+    case Distribution::Clustered: return "clustered";
+    case Distribution::Stacked:   return "stacked";
+    case Distribution::LongThin:  return "long-thin";
+  }
+  return "?";
+}
+
+const char* modeName(BroadphaseMode m) {
+  switch (m) {
+    case BroadphaseMode::SortAndSweep:     return "sort-and-sweep";
+    case BroadphaseMode::DynamicTree:      return "dynamic-tree";
+    case BroadphaseMode::SpatialHash:      return "spatial-hash";
+    case BroadphaseMode::IncrementalSweep: return "incremental-sweep";
+  }
+  return "?";
+}
+
+// Boxes of 0.1-0.3 units at a fixed density, so all sizes do similar work
+// per proxy.
+std::vector<AABB> makeBoxes(Distribution dist, int count, std::mt19937& rng) {
+  std::uniform_real_distribution<float> unit(0.f, 1.f);
+  std::normal_distribution<float> gauss(0.f, 1.f);
+  const float side = std::sqrt(static_cast<float>(count)) * 0.3f;
+
+  std::vector<AABB> boxes;
+  boxes.reserve(count);
+  std::vector<glm::vec2> clusters;
+  for (int i = 0; i < std::max(1, count / 500); ++i)
+    clusters.push_back({ unit(rng) * side, unit(rng) * side });
+
+  for (int i = 0; i < count; ++i) {
+    glm::vec2 half{ 0.05f + 0.1f * unit(rng), 0.05f + 0.1f * unit(rng) };
+    glm::vec2 c;
+    switch (dist) {
+      case Distribution::Uniform:
+        c = { unit(rng) * side, unit(rng) * side };
+        break;
+      case Distribution::Clustered: {
+        const glm::vec2& k = clusters[i % clusters.size()];
+        c = k + glm::vec2{ gauss(rng), gauss(rng) } * 1.5f;
+        break;
+      }
+      case Distribution::Stacked: {
+        int columns = std::max(1, count / 200);
+        c = { static_cast<float>(i % columns) * 0.6f,
+              static_cast<float>(i / columns) * 0.28f };
+        half = { 0.25f, 0.14f };
+        break;
+      }
+      case Distribution::LongThin: {
+        float angle  = unit(rng) * 3.14159265f;
+        float length = 1.f + 2.f * unit(rng);
+        glm::vec2 axis{ std::cos(angle), std::sin(angle) };
+        c = { unit(rng) * side, unit(rng) * side };
+        half = glm::abs(axis) * length * 0.5f + glm::vec2(0.02f);
+        break;
+      }
+    }
+    boxes.push_back({ c - half, c + half });
+  }
+  return boxes;
+}
+
+struct Result {
+  double msPerFrame = 0.0;
+  double pairs      = 0.0;
+};
+
+Result run(BroadphaseMode mode, const std::vector<AABB>& initial, int frames,
+           float cellSize, std::mt19937& rng) {
+  std::uniform_real_distribution<float> jitter(-0.01f, 0.01f);
+  std::vector<AABB> boxes = initial;
+  std::vector<entt::entity> entities(boxes.size());
+  for (size_t i = 0; i < boxes.size(); ++i)
+    entities[i] = static_cast<entt::entity>(i);
+
+  Broadphase bp;
+  bp.mode = mode;
+  if (cellSize > 0.f) bp.cellSize = cellSize;
+  std::vector<int32_t>         proxies;
+  std::vector<BroadphaseEntry> entries;
+  std::vector<BroadphasePair>  pairs;
+
+  if (mode == BroadphaseMode::DynamicTree) {
+    proxies.reserve(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i)
+      proxies.push_back(bp.createProxy(boxes[i], entities[i]));
+    bp.updatePairs();
+  }
+
+  using Clock = std::chrono::steady_clock;
+  Clock::duration total{};
+  size_t pairTotal = 0;
+
+  for (int f = 0; f < frames; ++f) {
+    for (auto& b : boxes) {
+      glm::vec2 d{ jitter(rng), jitter(rng) };
+      b.min += d;
+      b.max += d;
+    }
+
+    auto start = Clock::now();
+    size_t found = 0;
+    if (mode == BroadphaseMode::DynamicTree) {
+      for (size_t i = 0; i < boxes.size(); ++i)
+        bp.updateProxy(proxies[i], boxes[i]);
+      bp.updatePairs();
+      for (uint32_t slot : bp.pairs().live())
+        if (bp.touching(bp.pairs()[slot])) ++found;
+    } else {
+      entries.clear();
+      for (size_t i = 0; i < boxes.size(); ++i)
+        entries.push_back({ entities[i], boxes[i].fattened(bp.contactMargin) });
+      switch (mode) {
+        case BroadphaseMode::SpatialHash:      bp.findGridPairs(entries, pairs);         break;
+        case BroadphaseMode::IncrementalSweep: bp.findSweepPairs(entries, pairs);        break;
+        default:                               bp.findSortAndSweepPairs(entries, pairs); break;
+      }
+      found = pairs.size();
+    }
+    total += Clock::now() - start;
+    pairTotal += found;
+  }
+
+  Result r;
+  r.msPerFrame = std::chrono::duration<double, std::milli>(total).count() / frames;
+  r.pairs      = static_cast<double>(pairTotal) / frames;
+  return r;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int frames = 20;
+  float cellSize = 0.f;
+  std::string onlyDist, onlyMode;
+  std::vector<int> sizes;
+
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--frames") && i + 1 < argc)    frames   = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "--dist") && i + 1 < argc) onlyDist = argv[++i];
+    else if (!std::strcmp(argv[i], "--mode") && i + 1 < argc) onlyMode = argv[++i];
+    else if (!std::strcmp(argv[i], "--cell") && i + 1 < argc) cellSize = static_cast<float>(std::atof(argv[++i]));
+    else sizes.push_back(std::atoi(argv[i]));
+  }
+  if (sizes.empty()) sizes = { 1000, 10000, 100000 };
+  frames = std::max(frames, 1);
+
+  const Distribution dists[] = { Distribution::Uniform, Distribution::Clustered,
+                                 Distribution::Stacked, Distribution::LongThin };
+  const BroadphaseMode modes[] = { BroadphaseMode::SortAndSweep,
+                                   BroadphaseMode::IncrementalSweep,
+                                   BroadphaseMode::SpatialHash,
+                                   BroadphaseMode::DynamicTree };
+
+  std::printf("%-10s %8s  %-18s %10s %10s %10s %12s\n",
+              "dist", "proxies", "mode", "ms/frame", "ns/proxy", "pairs", "Mpairs/s");
+
+  for (Distribution dist : dists) {
+    if (!onlyDist.empty() && onlyDist != distName(dist)) continue;
+    for (int n : sizes) {
+      std::mt19937 rng(1234);
+      std::vector<AABB> boxes = makeBoxes(dist, n, rng);
+      for (BroadphaseMode mode : modes) {
+        if (!onlyMode.empty() && onlyMode != modeName(mode)) continue;
+        std::mt19937 jitterRng(99);
+        Result r = run(mode, boxes, frames, cellSize, jitterRng);
+        double nsPerProxy = r.msPerFrame * 1e6 / n;
+        double pairsPerSec = r.msPerFrame > 0.0 ? r.pairs / (r.msPerFrame * 1e-3) : 0.0;
+        std::printf("%-10s %8d  %-18s %10.3f %10.1f %10.0f %12.2f\n",
+                    distName(dist), n, modeName(mode), r.msPerFrame,
+                    nsPerProxy, r.pairs, pairsPerSec * 1e-6);
+      }
+    }
+  }
+  return 0;
+}
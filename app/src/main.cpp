@@ -10,6 +10,8 @@
 #include "physics/systems/collisionDetection.hpp"
 #include "physics/systems/mouseGrab.hpp"
 #include "physics/systems/constraintSolver.hpp"
+#include "physics/systems/continuousCollision.hpp"
+#include "physics/systems/sleepSystem.hpp"
 
 int main() {
   Scene scene;
@@ -28,10 +30,12 @@ int main() {
   auto& solver = physics.addSystem<ConstraintSolverSystem>();
   solver.velocityIterations = 12;
   solver.positionIterations = 4;
+  physics.addSystem<ContinuousCollisionSystem>();
+  physics.addSystem<SleepSystem>();
 
   grab.registerWithSolver(solver);
 
-  physics.setFixedTimestep(1.0f / 240.0f);
+  physics.setFixedTimestep(1.0f / 60.0f);
 
   Core core(scene, physics, timer, window, renderer, input);
   core.setFrameRateMode(FrameRateMode::VSync);
@@ -44,6 +44,10 @@ struct RigidBody2D {
 
   BodyType type          = BodyType::Dynamic;
   bool     fixedRotation = false;
+  bool     bullet        = false;   // swept against statics each step
+  glm::vec2 sweepStart{0.0f};       // bullets: position at the start of the step
+  bool     awake         = true;    // false while its island sleeps
+  float    sleepTime     = 0.0f;    // seconds spent under the sleep tolerances
 
   CollisionFilter filter;
 };
@@ -51,6 +55,22 @@ struct RigidBody2D {
 inline bool isStatic(const RigidBody2D& rb)    { return rb.type == BodyType::Static; }
 inline bool isKinematic(const RigidBody2D& rb) { return rb.type == BodyType::Kinematic; }
 inline bool isDynamic(const RigidBody2D& rb)   { return rb.type == BodyType::Dynamic; }
+inline bool isAsleep(const RigidBody2D& rb)    { return !rb.awake; }
+
+// Wakes this body only; the collision pass wakes the rest of its island
+// through the contacts it kept while asleep.
+inline void wakeBody(RigidBody2D& rb) {
+  rb.awake     = true;
+  rb.sleepTime = 0.0f;
+}
+
+inline void sleepBody(RigidBody2D& rb) {
+  rb.awake           = false;
+  rb.velocity        = {0, 0};
+  rb.angularVelocity = 0.0f;
+  rb.force           = {0, 0};
+  rb.torque          = 0.0f;
+}
 
 inline void syncBodyMass(RigidBody2D& rb) {
   if (rb.type != BodyType::Dynamic) {
@@ -70,6 +90,7 @@ inline void setBodyMass(RigidBody2D& rb, float m) {
 
 inline void setBodyType(RigidBody2D& rb, BodyType t) {
   rb.type = t;
+  wakeBody(rb);
   if (t != BodyType::Dynamic) {
     rb.velocity        = {0, 0};
     rb.angularVelocity = 0.0f;
@@ -83,7 +104,10 @@ inline void setBodyStatic(RigidBody2D& rb, bool s) {
   setBodyType(rb, s ? BodyType::Static : BodyType::Dynamic);
 }
 
-inline void addForce(RigidBody2D& rb, const glm::vec2& f) { rb.force += f; }
+inline void addForce(RigidBody2D& rb, const glm::vec2& f) {
+  rb.force += f;
+  wakeBody(rb);
+}
 
 inline void addForceAtPoint(RigidBody2D& rb,
                             const glm::vec2& f,
@@ -92,9 +116,13 @@ inline void addForceAtPoint(RigidBody2D& rb,
   rb.force  += f;
   glm::vec2 r = worldPoint - bodyPosition;
   rb.torque += r.x * f.y - r.y * f.x;
+  wakeBody(rb);
 }
 
-inline void addTorque(RigidBody2D& rb, float t) { rb.torque += t; }
+inline void addTorque(RigidBody2D& rb, float t) {
+  rb.torque += t;
+  wakeBody(rb);
+}
 
 inline void clearForces(RigidBody2D& rb) {
   rb.force  = {0, 0};
@@ -111,16 +139,23 @@ struct BoxCollider {
   glm::vec2 offset{0.0f};       
 };
 
+// A baked polygon shared by every collider that uses it. Shapes are interned
+// by the ShapeRegistry and never change afterwards; scale comes from the
+// body's transform at query time.
+struct ConvexShape {
+  const glm::vec2* vertices = nullptr;     // CCW
+  const glm::vec2* normals  = nullptr;     // edge i -> i+1
+  uint32_t  count       = 0;
+  glm::vec2 centroid{0.0f};                // area centroid
+  float     radius      = 0.0f;            // farthest surface point from the origin
+  float     rounding    = 0.0f;            // corner radius; two vertices make a capsule
+  float     area        = 0.0f;
+  float     unitInertia = 0.0f;            // about the centroid, per unit mass
+};
+
 struct ConvexCollider {
-  std::vector<glm::vec2> vertices; 
+  const ConvexShape* shape = nullptr;      // see internConvexShape()
   glm::vec2 offset{0.0f}; 
 
-  void ensureCCW() {
-    float area = 0.0f;
-    for (size_t i = 0; i < vertices.size(); ++i) {
-      size_t j = (i + 1) % vertices.size();
-      area += vertices[i].x * vertices[j].y - vertices[j].x * vertices[i].y;
-    }
-    if (area < 0.0f) std::reverse(vertices.begin(), vertices.end());
-  }
+  uint32_t vertexCount() const { return shape ? shape->count : 0; }
 };
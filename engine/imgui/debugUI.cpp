@@ -7,6 +7,7 @@
 #include "physics/systems/gravitySystem.hpp"
 #include "physics/systems/mouseGrab.hpp"
 #include "physics/contact.hpp"
+#include "physics/broadphase.hpp"
 #include "physics/collisionEvents.hpp"
 
 void DebugUI::update(float dt, PhysicsWorld& physics, Scene& scene) {
@@ -93,6 +94,25 @@ void DebugUI::update(float dt, PhysicsWorld& physics, Scene& scene) {
                          0.f, 5.f, "%.2f m/s");
     }
 
+    auto& reg = scene.getRegistry();
+    if (reg.ctx().contains<Broadphase>() &&
+        ImGui::CollapsingHeader("Broadphase")) {
+      auto& bp = reg.ctx().get<Broadphase>();
+      const char* modes[] = { "Sort and Sweep", "Dynamic Tree", "Spatial Hash", "Incremental Sweep" };
+      int mode = static_cast<int>(bp.mode);
+      if (ImGui::Combo("Mode", &mode, modes, IM_ARRAYSIZE(modes)))
+        bp.mode = static_cast<BroadphaseMode>(mode);
+      ImGui::SliderFloat("AABB Margin", &bp.aabbMargin, 0.f, 0.5f, "%.3f");
+      if (bp.mode == BroadphaseMode::SpatialHash)
+        ImGui::SliderFloat("Cell Size", &bp.cellSize, 0.05f, 2.f, "%.2f");
+      ImGui::Text("Tree proxies: %zu  height: %d",
+                  bp.tree().proxyCount(), bp.tree().height());
+      ImGui::Text("Static proxies: %zu  height: %d",
+                  bp.staticTree().proxyCount(), bp.staticTree().height());
+      ImGui::Text("Pairs: %zu  (+%zu / -%zu)", bp.pairs().size(),
+                  bp.pairs().added().size(), bp.pairs().removed().size());
+    }
+
     auto* grab = physics.getSystem<MouseGrabSystem>();
     if (grab && ImGui::CollapsingHeader("Mouse Grab")) {
       ImGui::SliderFloat("Frequency (Hz)", &grab->frequency, 0.5f, 20.f, "%.1f");
@@ -0,0 +1,137 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "components/transform.hpp"
+#include "components/physics_components.hpp"
+#include <algorithm>
+#include <cmath>
+
+struct AABB {
+  glm::vec2 min{0.f};
+  glm::vec2 max{0.f};
+
+  bool overlaps(const AABB& o) const {
+    return min.x <= o.max.x && max.x >= o.min.x &&
+           min.y <= o.max.y && max.y >= o.min.y;
+  }
+
+  bool contains(const AABB& o) const {
+    return min.x <= o.min.x && min.y <= o.min.y &&
+           max.x >= o.max.x && max.y >= o.max.y;
+  }
+
+  AABB fattened(float margin) const {
+    return { min - glm::vec2(margin), max + glm::vec2(margin) };
+  }
+
+  float perimeter() const {
+    return 2.f * ((max.x - min.x) + (max.y - min.y));
+  }
+
+  static AABB combine(const AABB& a, const AABB& b) {
+    return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+  }
+};
+
+// The overloads taking c/s expect cos/sin of xf.rotation, so callers that
+// cache the rotation can skip the trig.
+inline AABB computeCircleAABB(const TransformComponent& xf, float c, float s,
+                               const CircleCollider& cc) {
+  glm::vec2 worldOff = { c * cc.offset.x - s * cc.offset.y,
+                          s * cc.offset.x + c * cc.offset.y };
+  glm::vec2 center = xf.position + worldOff;
+  float r = cc.radius * std::max(xf.scale.x, xf.scale.y);
+  return { center - glm::vec2(r), center + glm::vec2(r) };
+}
+
+inline AABB computeBoxAABB(const TransformComponent& xf, float c, float s,
+                            const BoxCollider& bc) {
+  glm::vec2 center = xf.position + glm::vec2{
+    c * bc.offset.x - s * bc.offset.y,
+    s * bc.offset.x + c * bc.offset.y };
+  glm::vec2 half = bc.halfExtents * xf.scale;
+
+  float ex = std::abs(c * half.x) + std::abs(s * half.y);
+  float ey = std::abs(s * half.x) + std::abs(c * half.y);
+  return { center - glm::vec2{ex, ey}, center + glm::vec2{ex, ey} };
+}
+
+inline AABB computeConvexAABB(const TransformComponent& xf, float co, float si,
+                               const ConvexCollider& cv) {
+  if (cv.vertexCount() == 0)
+    return { xf.position, xf.position };
+
+  glm::vec2 center = xf.position + glm::vec2{
+    co * cv.offset.x - si * cv.offset.y,
+    si * cv.offset.x + co * cv.offset.y };
+
+  glm::vec2 mn{ 1e18f}, mx{-1e18f};
+  for (uint32_t i = 0; i < cv.shape->count; ++i) {
+    glm::vec2 sv = cv.shape->vertices[i] * xf.scale;
+    glm::vec2 wv = center + glm::vec2{co*sv.x - si*sv.y, si*sv.x + co*sv.y};
+    mn = glm::min(mn, wv);
+    mx = glm::max(mx, wv);
+  }
+  float skin = cv.shape->rounding * std::max(std::abs(xf.scale.x), std::abs(xf.scale.y));
+  return { mn - glm::vec2(skin), mx + glm::vec2(skin) };
+}
+
+inline AABB computeCircleAABB(const TransformComponent& xf,
+                               const CircleCollider& cc) {
+  return computeCircleAABB(xf, std::cos(xf.rotation), std::sin(xf.rotation), cc);
+}
+
+inline AABB computeBoxAABB(const TransformComponent& xf,
+                            const BoxCollider& bc) {
+  return computeBoxAABB(xf, std::cos(xf.rotation), std::sin(xf.rotation), bc);
+}
+
+inline AABB computeConvexAABB(const TransformComponent& xf,
+                               const ConvexCollider& cv) {
+  return computeConvexAABB(xf, std::cos(xf.rotation), std::sin(xf.rotation), cv);
+}
+
+// World AABB and rotation cached against the transform it was built from.
+// Bodies that did not move since the last refresh skip the trig and the
+// vertex loop; bodies that only translated shift the box kept relative to
+// their position. Drop the component when the collider itself changes.
+struct WorldAABB {
+  AABB               aabb;
+  float              cosR = 1.f;
+  float              sinR = 0.f;
+  TransformComponent snapshot;
+  bool               valid = false;
+
+  bool matches(const TransformComponent& xf) const {
+    return valid &&
+           snapshot.position == xf.position &&
+           snapshot.rotation == xf.rotation &&
+           snapshot.scale    == xf.scale;
+  }
+
+  // Returns true if the box was recomputed.
+  bool refresh(const TransformComponent& xf, const CircleCollider* cc,
+               const BoxCollider* bc, const ConvexCollider* cv) {
+    if (matches(xf)) return false;
+    if (valid && snapshot.rotation == xf.rotation && snapshot.scale == xf.scale) {
+      aabb     = { xf.position + m_relMin, xf.position + m_relMax };
+      snapshot = xf;
+      return true;
+    }
+    if (!valid || snapshot.rotation != xf.rotation) {
+      cosR = std::cos(xf.rotation);
+      sinR = std::sin(xf.rotation);
+    }
+    if (cc)      aabb = computeCircleAABB(xf, cosR, sinR, *cc);
+    else if (bc) aabb = computeBoxAABB(xf, cosR, sinR, *bc);
+    else if (cv) aabb = computeConvexAABB(xf, cosR, sinR, *cv);
+    m_relMin = aabb.min - xf.position;
+    m_relMax = aabb.max - xf.position;
+    snapshot = xf;
+    valid    = true;
+    return true;
+  }
+
+private:
+  glm::vec2 m_relMin{0.f};
+  glm::vec2 m_relMax{0.f};
+};
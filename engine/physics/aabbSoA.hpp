@@ -0,0 +1,112 @@
+#pragma once
+#include "aabb.hpp"
+#include <entt/entt.hpp>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using BroadphasePair = std::pair<entt::entity, entt::entity>;
+
+// AABBs split into one float array per bound, laid out along the sweep
+// axis: X is the axis the entries are sorted on and Y is the cross axis.
+// finish() appends kPadding sentinels so the kernels can read whole
+// vectors past the last entry without bounds checks; NaN fails every
+// ordered compare, so a sentinel never overlaps and always ends a run.
+struct AABBSoA {
+  static constexpr size_t kPadding = 8;
+
+  std::vector<float>        minX, minY, maxX, maxY;
+  std::vector<entt::entity> entity;
+
+  void clear() {
+    minX.clear(); minY.clear(); maxX.clear(); maxY.clear();
+    entity.clear();
+  }
+
+  void reserve(size_t n) {
+    minX.reserve(n + kPadding); minY.reserve(n + kPadding);
+    maxX.reserve(n + kPadding); maxY.reserve(n + kPadding);
+    entity.reserve(n);
+  }
+
+  void push(entt::entity e, const AABB& b, int axis = 0) {
+    const int cross = 1 - axis;
+    minX.push_back(b.min[axis]);  maxX.push_back(b.max[axis]);
+    minY.push_back(b.min[cross]); maxY.push_back(b.max[cross]);
+    entity.push_back(e);
+  }
+
+  void finish() {
+    constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+    for (size_t i = 0; i < kPadding; ++i) {
+      minX.push_back(nan);  maxX.push_back(nan);
+      minY.push_back(nan);  maxY.push_back(nan);
+    }
+  }
+
+  size_t size() const { return entity.size(); }
+};
+
+// Sweeps entries already sorted by minX. Each entry is tested against the
+// following ones a vector at a time; since minX is sorted, the first lane
+// that starts past the entry's maxX ends its run.
+inline void sweepSortedPairs(const AABBSoA& soa,
+                             std::vector<BroadphasePair>& pairs) {
+  const size_t n = soa.size();
+  const float* minX = soa.minX.data();
+  const float* minY = soa.minY.data();
+  const float* maxX = soa.maxX.data();
+  const float* maxY = soa.maxY.data();
+
+  for (size_t i = 0; i < n; ++i) {
+    size_t j = i + 1;
+
+#if defined(__AVX__)
+    const __m256 hiX = _mm256_set1_ps(maxX[i]);
+    const __m256 loY = _mm256_set1_ps(minY[i]);
+    const __m256 hiY = _mm256_set1_ps(maxY[i]);
+    for (;; j += 8) {
+      __m256 inX  = _mm256_cmp_ps(_mm256_loadu_ps(minX + j), hiX, _CMP_LE_OQ);
+      __m256 inY  = _mm256_and_ps(
+        _mm256_cmp_ps(_mm256_loadu_ps(minY + j), hiY, _CMP_LE_OQ),
+        _mm256_cmp_ps(_mm256_loadu_ps(maxY + j), loY, _CMP_GE_OQ));
+      int xMask   = _mm256_movemask_ps(inX);
+      int hits    = _mm256_movemask_ps(_mm256_and_ps(inX, inY));
+      while (hits) {
+        int k = __builtin_ctz(hits);
+        pairs.emplace_back(soa.entity[i], soa.entity[j + k]);
+        hits &= hits - 1;
+      }
+      if (xMask != 0xFF) break;
+    }
+#elif defined(__SSE2__)
+    const __m128 hiX = _mm_set1_ps(maxX[i]);
+    const __m128 loY = _mm_set1_ps(minY[i]);
+    const __m128 hiY = _mm_set1_ps(maxY[i]);
+    for (;; j += 4) {
+      __m128 inX  = _mm_cmple_ps(_mm_loadu_ps(minX + j), hiX);
+      __m128 inY  = _mm_and_ps(
+        _mm_cmple_ps(_mm_loadu_ps(minY + j), hiY),
+        _mm_cmpge_ps(_mm_loadu_ps(maxY + j), loY));
+      int xMask   = _mm_movemask_ps(inX);
+      int hits    = _mm_movemask_ps(_mm_and_ps(inX, inY));
+      while (hits) {
+        int k = __builtin_ctz(hits);
+        pairs.emplace_back(soa.entity[i], soa.entity[j + k]);
+        hits &= hits - 1;
+      }
+      if (xMask != 0xF) break;
+    }
+#else
+    for (; j < n && minX[j] <= maxX[i]; ++j) {
+      if (minY[j] <= maxY[i] && maxY[j] >= minY[i])
+        pairs.emplace_back(soa.entity[i], soa.entity[j]);
+    }
+#endif
+  }
+}
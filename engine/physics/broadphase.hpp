@@ -1,97 +1,524 @@
 #pragma once
+#include "aabb.hpp"
+#include "aabbSoA.hpp"
+#include "dynamicTree.hpp"
+#include "pairCache.hpp"
+#include "components/transform.hpp"
 #include <glm/glm.hpp>
 #include <entt/entt.hpp>
-#include "components/transform.hpp"
-#include "components/physics_components.hpp"
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <utility>
 
-struct AABB {
-  glm::vec2 min{0.f};
-  glm::vec2 max{0.f};
+struct BroadphaseEntry {
+  entt::entity entity;
+  AABB         aabb;
+};
+
+inline void
+sortAndSweep(std::vector<BroadphaseEntry>& entries,
+             std::vector<BroadphasePair>& pairs,
+             AABBSoA& soa) {
+  std::sort(entries.begin(), entries.end(),
+    [](const BroadphaseEntry& a, const BroadphaseEntry& b) {
+      return a.aabb.min.x < b.aabb.min.x;
+    });
+
+  pairs.clear();
+  pairs.reserve(entries.size());
+
+  soa.clear();
+  soa.reserve(entries.size());
+  for (const auto& e : entries)
+    soa.push(e.entity, e.aabb);
+  soa.finish();
+
+  sweepSortedPairs(soa, pairs);
+}
+
+// Uniform grid hashed into a bucket table sized to the input. A pair is
+// reported only from the cell holding the min corner of the two boxes'
+// intersection, so bodies spanning several shared cells are not repeated.
+class SpatialHashGrid {
+public:
+  static constexpr int kMaxCellsPerEntry = 64;
+
+  void findPairs(const std::vector<BroadphaseEntry>& entries, float cellSize,
+                 std::vector<BroadphasePair>& pairs) {
+    pairs.clear();
+    m_refs.clear();
+    m_oversized.clear();
+    if (entries.empty() || cellSize <= 0.f) return;
+
+    const float inv = 1.f / cellSize;
+
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+      const AABB& b = entries[i].aabb;
+      if (!std::isfinite(b.min.x) || !std::isfinite(b.min.y) ||
+          !std::isfinite(b.max.x) || !std::isfinite(b.max.y)) {
+        m_oversized.push_back(i);
+        continue;
+      }
+      int32_t x0 = cellCoord(b.min.x, inv), x1 = cellCoord(b.max.x, inv);
+      int32_t y0 = cellCoord(b.min.y, inv), y1 = cellCoord(b.max.y, inv);
+      if ((int64_t(x1) - x0 + 1) * (int64_t(y1) - y0 + 1) > kMaxCellsPerEntry) {
+        m_oversized.push_back(i);
+        continue;
+      }
+      for (int32_t y = y0; y <= y1; ++y)
+        for (int32_t x = x0; x <= x1; ++x)
+          m_refs.push_back({ x, y, i });
+    }
+
+    uint32_t bucketCount = 16;
+    while (bucketCount < m_refs.size() * 2) bucketCount <<= 1;
+    const uint32_t mask = bucketCount - 1;
+
+    m_bucketStart.assign(bucketCount + 1, 0);
+    for (auto& r : m_refs)
+      ++m_bucketStart[(hashCell(r.cx, r.cy) & mask) + 1];
+    for (uint32_t b = 0; b < bucketCount; ++b)
+      m_bucketStart[b + 1] += m_bucketStart[b];
+
+    m_sorted.resize(m_refs.size());
+    m_cursor.assign(m_bucketStart.begin(), m_bucketStart.end() - 1);
+    for (auto& r : m_refs)
+      m_sorted[m_cursor[hashCell(r.cx, r.cy) & mask]++] = r;
+
+    for (uint32_t b = 0; b < bucketCount; ++b) {
+      uint32_t begin = m_bucketStart[b], end = m_bucketStart[b + 1];
+      for (uint32_t i = begin; i < end; ++i) {
+        const CellRef& ri = m_sorted[i];
+        const AABB&    ai = entries[ri.entry].aabb;
+        for (uint32_t j = i + 1; j < end; ++j) {
+          const CellRef& rj = m_sorted[j];
+          if (ri.cx != rj.cx || ri.cy != rj.cy) continue;
+          const AABB& aj = entries[rj.entry].aabb;
+          if (!ai.overlaps(aj)) continue;
+
+          int32_t ox = cellCoord(std::max(ai.min.x, aj.min.x), inv);
+          int32_t oy = cellCoord(std::max(ai.min.y, aj.min.y), inv);
+          if (ox != ri.cx || oy != ri.cy) continue;
+
+          pairs.emplace_back(entries[ri.entry].entity, entries[rj.entry].entity);
+        }
+      }
+    }
 
-  bool overlaps(const AABB& o) const {
-    return min.x <= o.max.x && max.x >= o.min.x &&
-           min.y <= o.max.y && max.y >= o.min.y;
+    m_isOversized.assign(entries.size(), 0);
+    for (uint32_t i : m_oversized) m_isOversized[i] = 1;
+    for (uint32_t i : m_oversized) {
+      for (uint32_t j = 0; j < entries.size(); ++j) {
+        if (j == i || (m_isOversized[j] && j < i)) continue;
+        if (entries[i].aabb.overlaps(entries[j].aabb))
+          pairs.emplace_back(entries[i].entity, entries[j].entity);
+      }
+    }
+  }
+
+private:
+  struct CellRef {
+    int32_t  cx, cy;
+    uint32_t entry;
+  };
+
+  // Far-out coordinates share the border cells; the overlap test still
+  // sorts them out.
+  static int32_t cellCoord(float v, float inv) {
+    constexpr float kLimit = float(1 << 30);
+    return static_cast<int32_t>(std::clamp(std::floor(v * inv), -kLimit, kLimit));
   }
 
-  AABB fattened(float margin) const {
-    return { min - glm::vec2(margin), max + glm::vec2(margin) };
+  static uint32_t hashCell(int32_t x, int32_t y) {
+    return static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(y) * 19349663u;
   }
+
+  std::vector<CellRef>  m_refs;
+  std::vector<CellRef>  m_sorted;
+  std::vector<uint32_t> m_bucketStart;
+  std::vector<uint32_t> m_cursor;
+  std::vector<uint32_t> m_oversized;
+  std::vector<uint8_t>  m_isOversized;
 };
 
-inline AABB computeCircleAABB(const TransformComponent& xf,
-                               const CircleCollider& cc) {
-  float c = std::cos(xf.rotation), s = std::sin(xf.rotation);
-  glm::vec2 worldOff = { c * cc.offset.x - s * cc.offset.y,
-                          s * cc.offset.x + c * cc.offset.y };
-  glm::vec2 center = xf.position + worldOff;
-  float r = cc.radius * std::max(xf.scale.x, xf.scale.y);
-  return { center - glm::vec2(r), center + glm::vec2(r) };
-}
+// Sort-and-sweep that keeps its ordering between steps. Bodies move little
+// per step, so the insertion sort repairing last step's order is close to
+// linear. The sweep axis follows the larger variance of AABB centers.
+class IncrementalSweep {
+public:
+  void findPairs(const std::vector<BroadphaseEntry>& entries,
+                 std::vector<BroadphasePair>& pairs) {
+    pairs.clear();
+    ++m_stamp;
 
-inline AABB computeBoxAABB(const TransformComponent& xf,
-                            const BoxCollider& bc) {
-  float c = std::cos(xf.rotation), s = std::sin(xf.rotation);
-  glm::vec2 center = xf.position + glm::vec2{
-    c * bc.offset.x - s * bc.offset.y,
-    s * bc.offset.x + c * bc.offset.y };
-  glm::vec2 half = bc.halfExtents * xf.scale;
-
-  float ex = std::abs(c * half.x) + std::abs(s * half.y);
-  float ey = std::abs(s * half.x) + std::abs(c * half.y);
-  return { center - glm::vec2{ex, ey}, center + glm::vec2{ex, ey} };
-}
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+      uint32_t slot = entt::to_entity(entries[i].entity);
+      if (slot >= m_slots.size()) m_slots.resize(slot + 1);
+      m_slots[slot] = { entries[i].entity, i, m_stamp };
+    }
 
-inline AABB computeConvexAABB(const TransformComponent& xf,
-                               const ConvexCollider& cv) {
-  if (cv.vertices.empty())
-    return { xf.position, xf.position };
+    int axis = chooseAxis(entries);
+    bool axisChanged = axis != m_axis;
+    m_axis = axis;
 
-  float co = std::cos(xf.rotation), si = std::sin(xf.rotation);
-  glm::vec2 center = xf.position + glm::vec2{
-    co * cv.offset.x - si * cv.offset.y,
-    si * cv.offset.x + co * cv.offset.y };
+    // Keep last step's order for bodies that are still present, then
+    // append the newcomers.
+    m_sorted.clear();
+    for (entt::entity e : m_order) {
+      Slot& s = m_slots[entt::to_entity(e)];
+      if (s.stamp != m_stamp || s.entity != e) continue;
+      s.stamp = 0;
+      pushSorted(entries, s.entry);
+    }
+    size_t kept = m_sorted.size();
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+      Slot& s = m_slots[entt::to_entity(entries[i].entity)];
+      if (s.stamp != m_stamp) continue;
+      s.stamp = 0;
+      pushSorted(entries, i);
+    }
+
+    auto byMin = [](const SortedEntry& a, const SortedEntry& b) {
+      return a.min < b.min;
+    };
+    if (axisChanged || (m_sorted.size() - kept) * 8 > m_sorted.size()) {
+      std::sort(m_sorted.begin(), m_sorted.end(), byMin);
+    } else {
+      for (size_t i = 1; i < m_sorted.size(); ++i) {
+        SortedEntry key = m_sorted[i];
+        size_t j = i;
+        for (; j > 0 && key.min < m_sorted[j - 1].min; --j)
+          m_sorted[j] = m_sorted[j - 1];
+        m_sorted[j] = key;
+      }
+    }
+
+    m_order.resize(m_sorted.size());
+    m_soa.clear();
+    m_soa.reserve(m_sorted.size());
+    for (size_t i = 0; i < m_sorted.size(); ++i) {
+      const BroadphaseEntry& e = entries[m_sorted[i].entry];
+      m_order[i] = e.entity;
+      m_soa.push(e.entity, e.aabb, m_axis);
+    }
+    m_soa.finish();
 
-  glm::vec2 mn{ 1e18f}, mx{-1e18f};
-  for (auto& v : cv.vertices) {
-    glm::vec2 sv = v * xf.scale;
-    glm::vec2 wv = center + glm::vec2{co*sv.x - si*sv.y, si*sv.x + co*sv.y};
-    mn = glm::min(mn, wv);
-    mx = glm::max(mx, wv);
+    sweepSortedPairs(m_soa, pairs);
   }
-  return { mn, mx };
-}
 
-struct BroadphaseEntry {
-  entt::entity entity;
-  AABB         aabb;
+  int axis() const { return m_axis; }
+
+private:
+  struct Slot {
+    entt::entity entity = entt::null;
+    uint32_t     entry  = 0;
+    uint32_t     stamp  = 0;
+  };
+
+  struct SortedEntry {
+    float    min;
+    uint32_t entry;
+  };
+
+  void pushSorted(const std::vector<BroadphaseEntry>& entries, uint32_t i) {
+    m_sorted.push_back({ entries[i].aabb.min[m_axis], i });
+  }
+
+  // Switching axis costs a full sort, so only do it on a clear margin.
+  int chooseAxis(const std::vector<BroadphaseEntry>& entries) const {
+    if (entries.size() < 2) return m_axis;
+    glm::vec2 sum(0.f), sumSq(0.f);
+    for (const auto& e : entries) {
+      glm::vec2 c = (e.aabb.min + e.aabb.max) * 0.5f;
+      sum   += c;
+      sumSq += c * c;
+    }
+    float n = static_cast<float>(entries.size());
+    glm::vec2 var = sumSq / n - (sum / n) * (sum / n);
+    int other = 1 - m_axis;
+    return var[other] > var[m_axis] * 1.25f ? other : m_axis;
+  }
+
+  int                       m_axis  = 0;
+  uint32_t                  m_stamp = 0;
+  std::vector<Slot>         m_slots;
+  std::vector<entt::entity> m_order;
+  std::vector<SortedEntry>  m_sorted;
+  AABBSoA                   m_soa;
 };
 
-using BroadphasePair = std::pair<entt::entity, entt::entity>;
+enum class BroadphaseMode : uint8_t {
+  SortAndSweep     = 0,
+  DynamicTree      = 1,
+  SpatialHash      = 2,
+  IncrementalSweep = 3
+};
 
-inline void
-sortAndSweep(std::vector<BroadphaseEntry>& entries,
-             std::vector<BroadphasePair>& pairs) {
-  std::sort(entries.begin(), entries.end(),
-    [](const BroadphaseEntry& a, const BroadphaseEntry& b) {
-      return a.aabb.min.x < b.aabb.min.x;
-    });
+struct BroadphaseProxy {
+  int32_t id = DynamicTree::kNullNode;
+};
 
-  pairs.clear();
-  pairs.reserve(entries.size());
+// Proxy in the static tree. The snapshot is what the body looked like when
+// it was inserted; any difference means the static tree is out of date.
+struct StaticBroadphaseProxy {
+  int32_t            id = DynamicTree::kNullNode;
+  TransformComponent snapshot;
+
+  bool matches(const TransformComponent& xf) const {
+    return snapshot.position == xf.position &&
+           snapshot.rotation == xf.rotation &&
+           snapshot.scale    == xf.scale;
+  }
+};
+
+class Broadphase {
+public:
+  BroadphaseMode mode          = BroadphaseMode::DynamicTree;
+  float          aabbMargin    = 0.05f;
+  float          contactMargin = 0.01f;
+  float          cellSize      = 0.25f;
+
+  int32_t createProxy(const AABB& tight, entt::entity e) {
+    int32_t id = m_tree.createProxy(tight.fattened(aabbMargin), e);
+    growProxyArrays();
+    m_tight[id] = tight.fattened(contactMargin);
+    markMoved(id);
+    return id;
+  }
+
+  void destroyProxy(int32_t id) {
+    m_tree.destroyProxy(id);
+    ++m_proxyGen[id];
+    m_moved[id] = 0;
+  }
+
+  int32_t createStaticProxy(const AABB& tight, entt::entity e) {
+    m_staticDirty = true;
+    int32_t id = m_staticTree.createProxy(tight.fattened(contactMargin), e);
+    if (m_staticGen.size() < m_staticTree.nodeCapacity()) {
+      m_staticGen.resize(m_staticTree.nodeCapacity(), 0);
+      m_staticNew.resize(m_staticTree.nodeCapacity(), 0);
+    }
+    m_staticNew[id] = 1;
+    m_newStaticBuffer.push_back(id);
+    return id;
+  }
+
+  void destroyStaticProxy(int32_t id) {
+    m_staticDirty = true;
+    m_staticTree.destroyProxy(id);
+    ++m_staticGen[id];
+    m_staticNew[id] = 0;
+  }
+
+  void rebuildStaticIfDirty() {
+    if (!m_staticDirty) return;
+    m_staticTree.rebuild();
+    m_staticDirty = false;
+  }
+
+  bool updateProxy(int32_t id, const AABB& tight) {
+    m_tight[id] = tight.fattened(contactMargin);
+    if (m_tree.fatAABB(id).contains(tight)) return false;
+    m_tree.moveProxy(id, tight.fattened(aabbMargin));
+    growProxyArrays();
+    markMoved(id);
+    return true;
+  }
+
+  // Tree mode. Pairs whose proxies are gone or whose fat boxes separated
+  // are dropped; only proxies that were created or reinserted since the
+  // last step, plus new static proxies, look for new pairs.
+  void updatePairs() {
+    beginPairUpdate(BroadphaseMode::DynamicTree);
+
+    const auto& live = m_pairs.live();
+    for (size_t i = live.size(); i-- > 0;) {
+      uint32_t slot = live[i];
+      if (!stillOverlaps(m_pairs[slot])) m_pairs.remove(slot);
+    }
+
+    for (int32_t id : m_moveBuffer) {
+      if (!m_moved[id]) continue;
+      const AABB& fat = m_tree.fatAABB(id);
+      m_tree.query(fat, [&](int32_t other) {
+        if (other == id) return true;
+        if (m_moved[other] && other < id) return true;
+        addTreePair(id, other, false);
+        return true;
+      });
+      m_staticTree.query(fat, [&](int32_t other) {
+        addTreePair(id, other, true);
+        return true;
+      });
+    }
+
+    for (int32_t sid : m_newStaticBuffer) {
+      if (!m_staticNew[sid]) continue;
+      m_tree.query(m_staticTree.fatAABB(sid), [&](int32_t other) {
+        if (!m_moved[other]) addTreePair(other, sid, true);
+        return true;
+      });
+    }
+
+    clearMoveBuffers();
+  }
+
+  // Modes that rebuild their pair list every step feed it through here; the
+  // cache keeps slots for pairs that are still listed and drops the rest.
+  void syncPairs(const std::vector<BroadphasePair>& pairs) {
+    beginPairUpdate(mode);
+    clearMoveBuffers();
+
+    ++m_syncStamp;
+    for (const auto& [a, b] : pairs) {
+      uint32_t slot = m_pairs.add(a, b).first;
+      m_pairs[slot].stamp = m_syncStamp;
+    }
 
-  for (size_t i = 0; i < entries.size(); ++i) {
-    for (size_t j = i + 1; j < entries.size(); ++j) {
-      if (entries[j].aabb.min.x > entries[i].aabb.max.x)
-        break;
+    const auto& live = m_pairs.live();
+    for (size_t i = live.size(); i-- > 0;) {
+      uint32_t slot = live[i];
+      if (m_pairs[slot].stamp != m_syncStamp) m_pairs.remove(slot);
+    }
+  }
+
+  // Fat boxes keep a pair alive; the tight boxes decide whether it reaches
+  // the narrowphase this step.
+  bool touching(const PairCache::Pair& p) const {
+    if (p.proxyA < 0) return true;
+    const AABB& b = p.staticB ? m_staticTree.fatAABB(p.proxyB) : m_tight[p.proxyB];
+    return m_tight[p.proxyA].overlaps(b);
+  }
+
+  void findGridPairs(const std::vector<BroadphaseEntry>& entries,
+                     std::vector<BroadphasePair>& pairs) {
+    m_grid.findPairs(entries, cellSize, pairs);
+  }
+
+  void findSortAndSweepPairs(std::vector<BroadphaseEntry>& entries,
+                             std::vector<BroadphasePair>& pairs) {
+    sortAndSweep(entries, pairs, m_soa);
+  }
+
+  void findSweepPairs(const std::vector<BroadphaseEntry>& entries,
+                      std::vector<BroadphasePair>& pairs) {
+    m_sweep.findPairs(entries, pairs);
+  }
+
+  // Appends a pair for every static proxy touching one of the movers.
+  void findStaticPairs(const std::vector<BroadphaseEntry>& movers,
+                       std::vector<BroadphasePair>& pairs) const {
+    for (const auto& m : movers) {
+      m_staticTree.query(m.aabb, [&](int32_t other) {
+        pairs.emplace_back(m.entity, m_staticTree.entity(other));
+        return true;
+      });
+    }
+  }
+
+  const PairCache&   pairs()      const { return m_pairs; }
+  const DynamicTree& tree()       const { return m_tree; }
+  const DynamicTree& staticTree() const { return m_staticTree; }
+
+private:
+  void growProxyArrays() {
+    size_t cap = m_tree.nodeCapacity();
+    if (m_tight.size() >= cap) return;
+    m_tight.resize(cap);
+    m_proxyGen.resize(cap, 0);
+    m_moved.resize(cap, 0);
+  }
 
-      if (entries[i].aabb.min.y <= entries[j].aabb.max.y &&
-          entries[i].aabb.max.y >= entries[j].aabb.min.y) {
-        pairs.emplace_back(entries[i].entity, entries[j].entity);
+  void markMoved(int32_t id) {
+    if (m_moved[id]) return;
+    m_moved[id] = 1;
+    m_moveBuffer.push_back(id);
+  }
+
+  void clearMoveBuffers() {
+    for (int32_t id : m_moveBuffer) m_moved[id] = 0;
+    for (int32_t id : m_newStaticBuffer) m_staticNew[id] = 0;
+    m_moveBuffer.clear();
+    m_newStaticBuffer.clear();
+  }
+
+  // Switching modes starts the cache over. Entering tree mode re-queries
+  // every proxy, since pairs found by the other modes carry no proxy ids.
+  void beginPairUpdate(BroadphaseMode current) {
+    m_pairs.beginStep();
+    if (current == m_pairMode) return;
+    m_pairs.clear();
+    m_pairMode = current;
+    if (current != BroadphaseMode::DynamicTree) return;
+    m_tree.forEachProxy([&](int32_t id) { markMoved(id); });
+    m_staticTree.forEachProxy([&](int32_t id) {
+      if (!m_staticNew[id]) {
+        m_staticNew[id] = 1;
+        m_newStaticBuffer.push_back(id);
       }
+    });
+  }
+
+  void addTreePair(int32_t idA, int32_t idB, bool staticB) {
+    entt::entity a = m_tree.entity(idA);
+    entt::entity b = staticB ? m_staticTree.entity(idB) : m_tree.entity(idB);
+    auto [slot, inserted] = m_pairs.add(a, b);
+    if (!inserted) return;
+    auto& p   = m_pairs[slot];
+    p.proxyA  = idA;
+    p.proxyB  = idB;
+    p.genA    = m_proxyGen[idA];
+    p.genB    = staticB ? m_staticGen[idB] : m_proxyGen[idB];
+    p.staticB = staticB;
+  }
+
+  bool stillOverlaps(const PairCache::Pair& p) const {
+    if (m_proxyGen[p.proxyA] != p.genA) return false;
+    if (p.staticB) {
+      return m_staticGen[p.proxyB] == p.genB &&
+             m_tree.fatAABB(p.proxyA).overlaps(m_staticTree.fatAABB(p.proxyB));
     }
+    return m_proxyGen[p.proxyB] == p.genB &&
+           m_tree.fatAABB(p.proxyA).overlaps(m_tree.fatAABB(p.proxyB));
   }
+
+  DynamicTree           m_tree;
+  DynamicTree           m_staticTree;
+  SpatialHashGrid       m_grid;
+  IncrementalSweep      m_sweep;
+  AABBSoA               m_soa;
+  PairCache             m_pairs;
+  BroadphaseMode        m_pairMode    = BroadphaseMode::DynamicTree;
+  uint32_t              m_syncStamp   = 0;
+  bool                  m_staticDirty = false;
+  std::vector<AABB>     m_tight;
+  std::vector<uint32_t> m_proxyGen;
+  std::vector<uint8_t>  m_moved;
+  std::vector<int32_t>  m_moveBuffer;
+  std::vector<uint32_t> m_staticGen;
+  std::vector<uint8_t>  m_staticNew;
+  std::vector<int32_t>  m_newStaticBuffer;
+};
+
+inline void onBroadphaseProxyDestroyed(entt::registry& reg, entt::entity e) {
+  if (!reg.ctx().contains<Broadphase>()) return;
+  auto& proxy = reg.get<BroadphaseProxy>(e);
+  if (proxy.id != DynamicTree::kNullNode)
+    reg.ctx().get<Broadphase>().destroyProxy(proxy.id);
+}
+
+inline void onStaticProxyDestroyed(entt::registry& reg, entt::entity e) {
+  if (!reg.ctx().contains<Broadphase>()) return;
+  auto& proxy = reg.get<StaticBroadphaseProxy>(e);
+  if (proxy.id != DynamicTree::kNullNode)
+    reg.ctx().get<Broadphase>().destroyStaticProxy(proxy.id);
+}
+
+// Drops the body's proxies and cached bounds so the next step re-registers
+// it from scratch. Call after editing a collider in place.
+inline void invalidateBroadphaseProxy(entt::registry& reg, entt::entity e) {
+  reg.remove<BroadphaseProxy, StaticBroadphaseProxy, WorldAABB>(e);
 }
@@ -1,8 +1,8 @@
 #pragma once
 #include <entt/entt.hpp>
 #include <glm/glm.hpp>
+#include "pairCache.hpp"
 #include <vector>
-#include <unordered_set>
 #include <cstdint>
 
 struct CollisionEvent {
@@ -11,6 +11,7 @@ struct CollisionEvent {
   glm::vec2    normal{0.f};            
   glm::vec2    contactPoint{0.f};      
   float        penetration = 0.f;
+  uint32_t     pairId      = PairCache::kNullPair;
 };
 
 struct CollisionEvents {
@@ -25,52 +26,61 @@ struct CollisionEvents {
   }
 };
 
+// Begin/stay/end bookkeeping per broadphase pair slot. Pairs the broadphase
+// dropped end first, so a slot reused in the same step starts fresh.
 class CollisionPairTracker {
 public:
-  using PairKey = uint64_t;
-
-  static PairKey makeKey(entt::entity a, entt::entity b) {
-    auto lo = static_cast<uint32_t>(a);
-    auto hi = static_cast<uint32_t>(b);
-    if (lo > hi) std::swap(lo, hi);
-    return (static_cast<uint64_t>(hi) << 32) | lo;
-  }
-
   void update(const std::vector<CollisionEvent>& currentContacts,
+              const std::vector<uint32_t>& removedPairs,
               CollisionEvents& events) {
     events.clear();
+    ++m_stamp;
 
-    std::unordered_set<PairKey> currentKeys;
-    currentKeys.reserve(currentContacts.size());
+    for (uint32_t slot : removedPairs) {
+      if (slot < m_state.size() && m_state[slot].active) {
+        events.endContacts.push_back(m_state[slot].last);
+        m_state[slot].active = false;
+      }
+    }
 
     for (const auto& c : currentContacts) {
-      PairKey k = makeKey(c.entityA, c.entityB);
-      currentKeys.insert(k);
-
-      if (m_activePairs.count(k) == 0) {
-        events.beginContacts.push_back(c);
-      } else {
-        events.stayContacts.push_back(c);
-      }
+      if (c.pairId == PairCache::kNullPair) continue;
+      if (c.pairId >= m_state.size()) m_state.resize(c.pairId + 1);
+      State& st = m_state[c.pairId];
+      if (st.active) events.stayContacts.push_back(c);
+      else           events.beginContacts.push_back(c);
+      st.last   = c;
+      st.active = true;
+      st.stamp  = m_stamp;
     }
 
-    for (auto it = m_activePairs.begin(); it != m_activePairs.end(); ) {
-      if (currentKeys.count(it->first) == 0) {
-        events.endContacts.push_back(it->second);
-        it = m_activePairs.erase(it);
-      } else {
-        ++it;
+    for (uint32_t slot : m_activeSlots) {
+      State& st = m_state[slot];
+      if (st.active && st.stamp != m_stamp) {
+        events.endContacts.push_back(st.last);
+        st.active = false;
       }
     }
 
+    m_activeSlots.clear();
     for (const auto& c : currentContacts) {
-      PairKey k = makeKey(c.entityA, c.entityB);
-      m_activePairs[k] = c;
+      if (c.pairId != PairCache::kNullPair) m_activeSlots.push_back(c.pairId);
     }
   }
 
-  void clear() { m_activePairs.clear(); }
+  void clear() {
+    m_state.clear();
+    m_activeSlots.clear();
+  }
 
 private:
-  std::unordered_map<PairKey, CollisionEvent> m_activePairs;
+  struct State {
+    CollisionEvent last;
+    uint32_t       stamp  = 0;
+    bool           active = false;
+  };
+
+  std::vector<State>    m_state;
+  std::vector<uint32_t> m_activeSlots;
+  uint32_t              m_stamp = 0;
 };
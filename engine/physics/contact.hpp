@@ -1,22 +1,22 @@
 #pragma once
+#include "pairCache.hpp"
 #include <glm/glm.hpp>
 #include <entt/entt.hpp>
 #include <vector>
 #include <cstdint>
-#include <unordered_map>
 #include <algorithm>
 
 struct ContactFeature {
   enum Type : uint8_t { VERTEX = 0, FACE = 1 };
 
-  uint8_t indexA = 0; 
-  Type    typeA  = VERTEX;
-  uint8_t indexB = 0;
-  Type    typeB  = VERTEX;
+  uint16_t indexA = 0; 
+  Type     typeA  = VERTEX;
+  uint16_t indexB = 0;
+  Type     typeB  = VERTEX;
 
-  uint32_t key() const {
-    return (uint32_t(typeA) << 24) | (uint32_t(indexA) << 16) |
-           (uint32_t(typeB) << 8)  |  uint32_t(indexB);
+  uint64_t key() const {
+    return (uint64_t(typeA) << 48) | (uint64_t(indexA) << 32) |
+           (uint64_t(typeB) << 16) |  uint64_t(indexB);
   }
   bool operator==(const ContactFeature& o) const { return key() == o.key(); }
 };
@@ -25,7 +25,7 @@ struct ContactPoint {
   glm::vec2 position{0.f};
   glm::vec2 localA{0.f}; 
   glm::vec2 localB{0.f};   
-  float     penetration = 0.f; 
+  float     penetration = 0.f;   // negative for speculative points
   ContactFeature feature;
 
   float normalImpulse  = 0.f;
@@ -36,6 +36,22 @@ struct ContactPoint {
   float     normalMass  = 0.f; 
   float     tangentMass = 0.f;
   float     velocityBias = 0.f;
+
+  // Soft step: separation with the anchor offset taken out, so it can be
+  // rebuilt from how far the bodies moved, and the approach speed at the
+  // start of the step for restitution.
+  float     adjustedSeparation = 0.f;
+  float     relativeVelocity   = 0.f;
+  float     maxNormalImpulse   = 0.f;
+};
+
+// Pose of bodyB in bodyA's frame when a manifold was last built from
+// scratch, with the normal in A's frame. A pair that has barely moved from
+// it can keep the manifold instead of colliding again.
+struct ManifoldPose {
+  glm::vec2 relPosition{0.f};
+  float     relRotation = 0.f;
+  glm::vec2 localNormal{0.f};
 };
 
 struct ContactConstraint {
@@ -46,37 +62,43 @@ struct ContactConstraint {
   int          pointCount = 0;
   float        friction    = 0.f;
   float        restitution = 0.f;
+  uint32_t     pairId      = PairCache::kNullPair;
+  ManifoldPose pose;
 };
 
-inline uint64_t contactPairKey(entt::entity a, entt::entity b) {
-  auto lo = static_cast<uint32_t>(a);
-  auto hi = static_cast<uint32_t>(b);
-  if (lo > hi) std::swap(lo, hi);
-  return (static_cast<uint64_t>(hi) << 32) | lo;
-}
-
+// Contacts are keyed by broadphase pair slot. Slots of removed pairs must
+// be released through removePairs() before the next update(), since the
+// cache may hand them out again.
 class ContactManager {
 public:
-  void update(const std::vector<ContactConstraint>& newContacts) {
-    m_oldLookup.clear();
-    m_oldLookup.reserve(m_contacts.size());
-    for (size_t i = 0; i < m_contacts.size(); ++i) {
-      uint64_t key = contactPairKey(m_contacts[i].bodyA, m_contacts[i].bodyB);
-      m_oldLookup[key] = i;
+  void removePairs(const std::vector<uint32_t>& removed) {
+    for (uint32_t slot : removed) {
+      if (slot < m_bySlot.size()) m_bySlot[slot] = kNone;
     }
+  }
 
+  void update(const std::vector<ContactConstraint>& newContacts) {
     m_staging.clear();
     m_staging.reserve(newContacts.size());
 
     for (const auto& nc : newContacts) {
       m_staging.push_back(nc);
-      uint64_t key = contactPairKey(nc.bodyA, nc.bodyB);
-      auto it = m_oldLookup.find(key);
-      if (it != m_oldLookup.end()) {
-        warmMatch(m_staging.back(), m_contacts[it->second]);
-      }
+      if (nc.pairId >= m_bySlot.size()) continue;
+      uint32_t old = m_bySlot[nc.pairId];
+      if (old != kNone) warmMatch(m_staging.back(), m_contacts[old]);
+    }
+
+    for (const auto& oc : m_contacts) {
+      if (oc.pairId < m_bySlot.size()) m_bySlot[oc.pairId] = kNone;
     }
     std::swap(m_contacts, m_staging);
+
+    for (uint32_t i = 0; i < m_contacts.size(); ++i) {
+      uint32_t slot = m_contacts[i].pairId;
+      if (slot == PairCache::kNullPair) continue;
+      if (slot >= m_bySlot.size()) m_bySlot.resize(slot + 1, kNone);
+      m_bySlot[slot] = i;
+    }
   }
 
   auto begin()       { return m_contacts.begin(); }
@@ -86,12 +108,23 @@ public:
   size_t size() const { return m_contacts.size(); }
   bool empty()  const { return m_contacts.empty();}
 
+  // Last step's contact for a pair slot, or null if it had none.
+  const ContactConstraint* find(uint32_t slot) const {
+    if (slot >= m_bySlot.size() || m_bySlot[slot] == kNone) return nullptr;
+    return &m_contacts[m_bySlot[slot]];
+  }
+
   ContactConstraint& operator[](size_t i) { return m_contacts[i]; }
   const ContactConstraint& operator[](size_t i) const { return m_contacts[i]; }
 
-  void clear() { m_contacts.clear(); }
+  void clear() {
+    m_contacts.clear();
+    m_bySlot.clear();
+  }
 
 private:
+  static constexpr uint32_t kNone = PairCache::kNullPair;
+
   void warmMatch(ContactConstraint& nc, const ContactConstraint& oc) {
     for (int i = 0; i < nc.pointCount; ++i) {
       for (int j = 0; j < oc.pointCount; ++j) {
@@ -106,5 +139,5 @@ private:
 
   std::vector<ContactConstraint> m_contacts;
   std::vector<ContactConstraint> m_staging;
-  std::unordered_map<uint64_t, size_t> m_oldLookup;
+  std::vector<uint32_t>          m_bySlot;
 };
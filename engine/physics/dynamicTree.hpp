@@ -0,0 +1,434 @@
+#pragma once
+#include "aabb.hpp"
+#include <entt/entt.hpp>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+// Bounding volume hierarchy over fat AABBs. Leaves are proxies that keep
+// their fat box until the tight box escapes it, so resting and slowly
+// moving bodies never touch the tree. Insertion uses a surface-area
+// heuristic and local tree rotations to keep node overlap low.
+class DynamicTree {
+public:
+  static constexpr int32_t kNullNode = -1;
+
+  DynamicTree() {
+    m_nodes.reserve(16);
+  }
+
+  int32_t createProxy(const AABB& fatAABB, entt::entity entity) {
+    int32_t id = allocateNode();
+    m_nodes[id].aabb   = fatAABB;
+    m_nodes[id].entity = entity;
+    m_nodes[id].height = 0;
+    insertLeaf(id);
+    ++m_proxyCount;
+    return id;
+  }
+
+  void destroyProxy(int32_t id) {
+    assert(id >= 0 && id < static_cast<int32_t>(m_nodes.size()));
+    assert(m_nodes[id].isLeaf());
+    removeLeaf(id);
+    freeNode(id);
+    --m_proxyCount;
+  }
+
+  void moveProxy(int32_t id, const AABB& fatAABB) {
+    assert(m_nodes[id].isLeaf());
+    removeLeaf(id);
+    m_nodes[id].aabb = fatAABB;
+    insertLeaf(id);
+  }
+
+  // Rebuilds every internal node top-down with median splits. Proxy ids
+  // are preserved. Meant for trees that change rarely, like static geometry.
+  void rebuild() {
+    m_leaves.clear();
+    for (int32_t i = 0; i < static_cast<int32_t>(m_nodes.size()); ++i) {
+      if (m_nodes[i].height < 0) continue;
+      if (m_nodes[i].isLeaf()) m_leaves.push_back(i);
+      else                     freeNode(i);
+    }
+    m_root = m_leaves.empty()
+           ? kNullNode
+           : buildTopDown(m_leaves.data(), static_cast<int32_t>(m_leaves.size()));
+    if (m_root != kNullNode) m_nodes[m_root].parent = kNullNode;
+  }
+
+  const AABB&  fatAABB(int32_t id) const { return m_nodes[id].aabb; }
+  entt::entity entity(int32_t id)  const { return m_nodes[id].entity; }
+
+  int32_t height() const {
+    return m_root == kNullNode ? 0 : m_nodes[m_root].height;
+  }
+  size_t proxyCount() const { return m_proxyCount; }
+  size_t nodeCapacity() const { return m_nodes.size(); }
+
+  // nodeTest(const AABB&) -> bool decides whether to descend into a node;
+  // fn(int32_t proxyId) -> bool is called on accepted leaves, false stops.
+  template<typename Test, typename Fn>
+  void traverse(Test&& nodeTest, Fn&& fn) const {
+    if (m_root == kNullNode) return;
+
+    int32_t  inlineStack[kStackSize];
+    int32_t* stack = inlineStack;
+    std::vector<int32_t> overflow;
+    int32_t  count = 0;
+    int32_t  cap   = kStackSize;
+
+    stack[count++] = m_root;
+    while (count > 0) {
+      int32_t id = stack[--count];
+      const TreeNode& node = m_nodes[id];
+      if (!nodeTest(node.aabb)) continue;
+
+      if (node.isLeaf()) {
+        if (!fn(id)) return;
+        continue;
+      }
+
+      if (count + 2 > cap) {
+        if (overflow.empty())
+          overflow.assign(inlineStack, inlineStack + count);
+        overflow.resize(static_cast<size_t>(cap) * 2);
+        stack = overflow.data();
+        cap   = static_cast<int32_t>(overflow.size());
+      }
+      stack[count++] = node.child1;
+      stack[count++] = node.child2;
+    }
+  }
+
+  // fn(int32_t proxyId) -> bool; return false to stop the query.
+  template<typename Fn>
+  void query(const AABB& box, Fn&& fn) const {
+    traverse([&](const AABB& b) { return b.overlaps(box); }, fn);
+  }
+
+  // Segment p1 -> p1 + maxFraction * (p2 - p1). fn(int32_t proxyId, float
+  // maxFraction) -> float: the returned fraction clips the segment for the
+  // rest of the traversal, 0 stops it, and a negative value leaves it as is.
+  template<typename Fn>
+  void rayCast(const glm::vec2& p1, const glm::vec2& p2, float maxFraction,
+               Fn&& fn) const {
+    const glm::vec2 d = p2 - p1;
+    const glm::vec2 invD{
+      d.x != 0.f ? 1.f / d.x : std::numeric_limits<float>::infinity(),
+      d.y != 0.f ? 1.f / d.y : std::numeric_limits<float>::infinity() };
+
+    traverse(
+      [&](const AABB& b) { return segmentHitsBox(b, p1, d, invD, maxFraction); },
+      [&](int32_t id) {
+        float value = fn(id, maxFraction);
+        if (value == 0.f) return false;
+        if (value > 0.f) maxFraction = std::min(maxFraction, value);
+        return true;
+      });
+  }
+
+  template<typename Fn>
+  void forEachProxy(Fn&& fn) const {
+    for (int32_t i = 0; i < static_cast<int32_t>(m_nodes.size()); ++i) {
+      if (m_nodes[i].height == 0) fn(i);
+    }
+  }
+
+private:
+  static constexpr int32_t kStackSize = 256;
+
+  struct TreeNode {
+    AABB         aabb;
+    entt::entity entity = entt::null;
+    int32_t      parent = kNullNode;  // doubles as the free-list link
+    int32_t      child1 = kNullNode;
+    int32_t      child2 = kNullNode;
+    int32_t      height = -1;         // leaf = 0, free = -1
+
+    bool isLeaf() const { return child1 == kNullNode; }
+  };
+
+  std::vector<TreeNode> m_nodes;
+  std::vector<int32_t>  m_leaves;
+  int32_t m_root       = kNullNode;
+  int32_t m_freeList   = kNullNode;
+  size_t  m_proxyCount = 0;
+
+  // Slab test of the segment p1 + t * d, t in [0, maxFraction].
+  static bool segmentHitsBox(const AABB& box, const glm::vec2& p1,
+                             const glm::vec2& d, const glm::vec2& invD,
+                             float maxFraction) {
+    float tMin = 0.f, tMax = maxFraction;
+    for (int axis = 0; axis < 2; ++axis) {
+      if (d[axis] == 0.f) {
+        if (p1[axis] < box.min[axis] || p1[axis] > box.max[axis]) return false;
+        continue;
+      }
+      float t1 = (box.min[axis] - p1[axis]) * invD[axis];
+      float t2 = (box.max[axis] - p1[axis]) * invD[axis];
+      if (t1 > t2) std::swap(t1, t2);
+      tMin = std::max(tMin, t1);
+      tMax = std::min(tMax, t2);
+      if (tMin > tMax) return false;
+    }
+    return true;
+  }
+
+  int32_t allocateNode() {
+    if (m_freeList == kNullNode) {
+      m_nodes.emplace_back();
+      return static_cast<int32_t>(m_nodes.size() - 1);
+    }
+    int32_t id = m_freeList;
+    m_freeList = m_nodes[id].parent;
+    m_nodes[id] = TreeNode{};
+    return id;
+  }
+
+  void freeNode(int32_t id) {
+    m_nodes[id].parent = m_freeList;
+    m_nodes[id].height = -1;
+    m_nodes[id].entity = entt::null;
+    m_freeList = id;
+  }
+
+  int32_t buildTopDown(int32_t* leaves, int32_t count) {
+    if (count == 1) return leaves[0];
+
+    AABB centers{ glm::vec2(1e18f), glm::vec2(-1e18f) };
+    for (int32_t i = 0; i < count; ++i) {
+      const AABB& b = m_nodes[leaves[i]].aabb;
+      glm::vec2 c = 0.5f * (b.min + b.max);
+      centers.min = glm::min(centers.min, c);
+      centers.max = glm::max(centers.max, c);
+    }
+    glm::vec2 extent = centers.max - centers.min;
+    int axis = extent.x >= extent.y ? 0 : 1;
+
+    int32_t half = count / 2;
+    std::nth_element(leaves, leaves + half, leaves + count,
+      [&](int32_t a, int32_t b) {
+        const AABB& ba = m_nodes[a].aabb;
+        const AABB& bb = m_nodes[b].aabb;
+        return ba.min[axis] + ba.max[axis] < bb.min[axis] + bb.max[axis];
+      });
+
+    int32_t c1 = buildTopDown(leaves, half);
+    int32_t c2 = buildTopDown(leaves + half, count - half);
+
+    int32_t id = allocateNode();
+    TreeNode& node = m_nodes[id];
+    node.child1 = c1;
+    node.child2 = c2;
+    node.aabb   = AABB::combine(m_nodes[c1].aabb, m_nodes[c2].aabb);
+    node.height = 1 + std::max(m_nodes[c1].height, m_nodes[c2].height);
+    m_nodes[c1].parent = id;
+    m_nodes[c2].parent = id;
+    return id;
+  }
+
+  void insertLeaf(int32_t leaf) {
+    if (m_root == kNullNode) {
+      m_root = leaf;
+      m_nodes[leaf].parent = kNullNode;
+      return;
+    }
+
+    const AABB leafAABB = m_nodes[leaf].aabb;
+    int32_t sibling   = findBestSibling(leafAABB);
+    int32_t oldParent = m_nodes[sibling].parent;
+    int32_t newParent = allocateNode();
+    m_nodes[newParent].parent = oldParent;
+    m_nodes[newParent].aabb   = AABB::combine(leafAABB, m_nodes[sibling].aabb);
+    m_nodes[newParent].height = m_nodes[sibling].height + 1;
+    m_nodes[newParent].child1 = sibling;
+    m_nodes[newParent].child2 = leaf;
+    m_nodes[sibling].parent   = newParent;
+    m_nodes[leaf].parent      = newParent;
+
+    if (oldParent != kNullNode) {
+      if (m_nodes[oldParent].child1 == sibling)
+        m_nodes[oldParent].child1 = newParent;
+      else
+        m_nodes[oldParent].child2 = newParent;
+    } else {
+      m_root = newParent;
+    }
+
+    for (int32_t index = oldParent; index != kNullNode;
+         index = m_nodes[index].parent) {
+      TreeNode& node = m_nodes[index];
+      node.aabb   = AABB::combine(m_nodes[node.child1].aabb,
+                                  m_nodes[node.child2].aabb);
+      node.height = 1 + std::max(m_nodes[node.child1].height,
+                                 m_nodes[node.child2].height);
+      rotate(index);
+    }
+  }
+
+  void removeLeaf(int32_t leaf) {
+    if (leaf == m_root) {
+      m_root = kNullNode;
+      return;
+    }
+
+    int32_t parent      = m_nodes[leaf].parent;
+    int32_t grandParent = m_nodes[parent].parent;
+    int32_t sibling     = (m_nodes[parent].child1 == leaf)
+                        ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    if (grandParent == kNullNode) {
+      m_root = sibling;
+      m_nodes[sibling].parent = kNullNode;
+      freeNode(parent);
+      return;
+    }
+
+    if (m_nodes[grandParent].child1 == parent)
+      m_nodes[grandParent].child1 = sibling;
+    else
+      m_nodes[grandParent].child2 = sibling;
+    m_nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    for (int32_t index = grandParent; index != kNullNode;
+         index = m_nodes[index].parent) {
+      TreeNode& node = m_nodes[index];
+      node.aabb   = AABB::combine(m_nodes[node.child1].aabb,
+                                  m_nodes[node.child2].aabb);
+      node.height = 1 + std::max(m_nodes[node.child1].height,
+                                 m_nodes[node.child2].height);
+    }
+  }
+
+  // Branch-and-bound descent for the sibling that minimises the total
+  // perimeter added to the tree by inserting box.
+  int32_t findBestSibling(const AABB& box) const {
+    const glm::vec2 center = 0.5f * (box.min + box.max);
+    const float     areaD  = box.perimeter();
+
+    int32_t index      = m_root;
+    float   areaBase   = m_nodes[index].aabb.perimeter();
+    float   directCost = AABB::combine(m_nodes[index].aabb, box).perimeter();
+    float   inherited  = 0.f;
+
+    int32_t best     = index;
+    float   bestCost = directCost;
+
+    while (!m_nodes[index].isLeaf()) {
+      int32_t c1 = m_nodes[index].child1;
+      int32_t c2 = m_nodes[index].child2;
+
+      float cost = directCost + inherited;
+      if (cost < bestCost) {
+        best     = index;
+        bestCost = cost;
+      }
+      inherited += directCost - areaBase;
+
+      auto lowerBound = [&](int32_t child, float& direct, float& area) {
+        const TreeNode& n = m_nodes[child];
+        direct = AABB::combine(n.aabb, box).perimeter();
+        if (n.isLeaf()) {
+          if (direct + inherited < bestCost) {
+            best     = child;
+            bestCost = direct + inherited;
+          }
+          area = 0.f;
+          return std::numeric_limits<float>::max();
+        }
+        area = n.aabb.perimeter();
+        return inherited + direct + std::min(areaD - area, 0.f);
+      };
+
+      float direct1, area1, direct2, area2;
+      float lower1 = lowerBound(c1, direct1, area1);
+      float lower2 = lowerBound(c2, direct2, area2);
+
+      bool leaf1 = m_nodes[c1].isLeaf();
+      bool leaf2 = m_nodes[c2].isLeaf();
+      if (leaf1 && leaf2) break;
+      if (bestCost <= lower1 && bestCost <= lower2) break;
+
+      if (lower1 == lower2 && !leaf1) {
+        glm::vec2 d1 = 0.5f * (m_nodes[c1].aabb.min + m_nodes[c1].aabb.max) - center;
+        glm::vec2 d2 = 0.5f * (m_nodes[c2].aabb.min + m_nodes[c2].aabb.max) - center;
+        lower1 = glm::dot(d1, d1);
+        lower2 = glm::dot(d2, d2);
+      }
+
+      if (lower1 < lower2 && !leaf1) {
+        index      = c1;
+        areaBase   = area1;
+        directCost = direct1;
+      } else {
+        index      = c2;
+        areaBase   = area2;
+        directCost = direct2;
+      }
+    }
+    return best;
+  }
+
+  // Swaps a child of A with a grandchild when that shrinks the perimeter
+  // of A's subtree. A's own box is unchanged by any of the swaps.
+  void rotate(int32_t iA) {
+    TreeNode& A = m_nodes[iA];
+    if (A.height < 2) return;
+
+    int32_t iB = A.child1;
+    int32_t iC = A.child2;
+    TreeNode& B = m_nodes[iB];
+    TreeNode& C = m_nodes[iC];
+
+    enum { None, BF, BG, CD, CE } best = None;
+    float bestCost = 0.f;
+    AABB  bestBox;
+
+    if (!C.isLeaf()) {
+      const AABB& F = m_nodes[C.child1].aabb;
+      const AABB& G = m_nodes[C.child2].aabb;
+      float areaC = C.aabb.perimeter();
+      AABB bg = AABB::combine(B.aabb, G);
+      AABB bf = AABB::combine(B.aabb, F);
+      float gainBF = areaC - bg.perimeter();
+      float gainBG = areaC - bf.perimeter();
+      if (gainBF > bestCost) { best = BF; bestCost = gainBF; bestBox = bg; }
+      if (gainBG > bestCost) { best = BG; bestCost = gainBG; bestBox = bf; }
+    }
+    if (!B.isLeaf()) {
+      const AABB& D = m_nodes[B.child1].aabb;
+      const AABB& E = m_nodes[B.child2].aabb;
+      float areaB = B.aabb.perimeter();
+      AABB ce = AABB::combine(C.aabb, E);
+      AABB cd = AABB::combine(C.aabb, D);
+      float gainCD = areaB - ce.perimeter();
+      float gainCE = areaB - cd.perimeter();
+      if (gainCD > bestCost) { best = CD; bestCost = gainCD; bestBox = ce; }
+      if (gainCE > bestCost) { best = CE; bestCost = gainCE; bestBox = cd; }
+    }
+
+    auto swapInto = [&](int32_t iParent, int32_t& parentSlot, int32_t iMoved,
+                        int32_t& aSlot, int32_t iDown, int32_t iStay) {
+      parentSlot = iDown;
+      aSlot      = iMoved;
+      m_nodes[iDown].parent  = iParent;
+      m_nodes[iMoved].parent = iA;
+      m_nodes[iParent].aabb   = bestBox;
+      m_nodes[iParent].height = 1 + std::max(m_nodes[iDown].height,
+                                             m_nodes[iStay].height);
+      A.height = 1 + std::max(m_nodes[iParent].height, m_nodes[iMoved].height);
+    };
+
+    switch (best) {
+      case BF: swapInto(iC, C.child1, C.child1, A.child1, iB, C.child2); break;
+      case BG: swapInto(iC, C.child2, C.child2, A.child1, iB, C.child1); break;
+      case CD: swapInto(iB, B.child1, B.child1, A.child2, iC, B.child2); break;
+      case CE: swapInto(iB, B.child2, B.child2, A.child2, iC, B.child1); break;
+      case None: break;
+    }
+  }
+};
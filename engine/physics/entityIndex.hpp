@@ -0,0 +1,45 @@
+#pragma once
+#include <entt/entt.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Dense per-step indices looked up by entity index. Entries are stamped
+// with the step they were written in, so clear() never touches the table.
+class EntityIndex {
+public:
+  static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+  void clear() {
+    if (++m_frame == 0) {
+      std::fill(m_table.begin(), m_table.end(), Stamp{});
+      m_frame = 1;
+    }
+  }
+
+  uint32_t find(entt::entity e) const {
+    if (e == entt::null) return kNone;
+    const auto id = entt::to_entity(e);
+    if (id >= m_table.size() || m_table[id].frame != m_frame) return kNone;
+    return m_table[id].index;
+  }
+
+  // The index e already has this step, or else index.
+  uint32_t insert(entt::entity e, uint32_t index) {
+    const auto id = entt::to_entity(e);
+    if (id >= m_table.size()) m_table.resize(id + 1);
+    Stamp& stamp = m_table[id];
+    if (stamp.frame != m_frame) stamp = { m_frame, index };
+    return stamp.index;
+  }
+
+private:
+  struct Stamp {
+    uint32_t frame = 0;
+    uint32_t index = kNone;
+  };
+
+  std::vector<Stamp> m_table;
+  uint32_t           m_frame = 0;
+};
@@ -1,17 +1,16 @@
 #pragma once
 #include "contact.hpp"
+#include "simd.hpp"
 #include "components/transform.hpp"
 #include "components/physics_components.hpp"
 #include <glm/glm.hpp>
 #include <cmath>
 #include <algorithm>
 #include <limits>
-#include <optional>
+#include <vector>
 
 namespace narrowphase {
 
-static constexpr int MAX_POLY = 16;
-
 inline glm::vec2 rotate(const glm::vec2& v, float c, float s) {
   return { c * v.x - s * v.y, s * v.x + c * v.y };
 }
@@ -20,18 +19,27 @@ inline glm::vec2 rotateInv(const glm::vec2& v, float c, float s) {
   return { c * v.x + s * v.y, -s * v.x + c * v.y };
 }
 
-inline glm::vec2 worldCenter(const TransformComponent& xf,
+inline glm::vec2 worldCenter(const TransformComponent& xf, float c, float s,
                               const glm::vec2& offset) {
-  float c = std::cos(xf.rotation), s = std::sin(xf.rotation);
   return xf.position + rotate(offset, c, s);
 }
 
+inline glm::vec2 worldCenter(const TransformComponent& xf,
+                              const glm::vec2& offset) {
+  return worldCenter(xf, std::cos(xf.rotation), std::sin(xf.rotation), offset);
+}
+
+inline int hullCount(const BoxCollider* box, const ConvexCollider* convex) {
+  if (box) return 4;
+  return convex ? static_cast<int>(convex->vertexCount()) : 0;
+}
+
+// out needs room for hullCount(box, convex) vertices.
 inline int getWorldPoly(glm::vec2* out, const TransformComponent& xf,
+                         float c, float s,
                          const BoxCollider* box, const ConvexCollider* convex) {
-  float c = std::cos(xf.rotation), s = std::sin(xf.rotation);
-
   if (box) {
-    glm::vec2 center = worldCenter(xf, box->offset);
+    glm::vec2 center = worldCenter(xf, c, s, box->offset);
     glm::vec2 half   = box->halfExtents * xf.scale;
     glm::vec2 ax{c, s}, ay{-s, c};
     out[0] = center - half.x * ax - half.y * ay;
@@ -41,11 +49,11 @@ inline int getWorldPoly(glm::vec2* out, const TransformComponent& xf,
     return 4;
   }
 
-  if (convex && !convex->vertices.empty()) {
-    glm::vec2 center = worldCenter(xf, convex->offset);
-    int n = std::min(static_cast<int>(convex->vertices.size()), MAX_POLY);
+  if (convex && convex->vertexCount() > 0) {
+    glm::vec2 center = worldCenter(xf, c, s, convex->offset);
+    const int n = static_cast<int>(convex->shape->count);
     for (int i = 0; i < n; ++i) {
-      glm::vec2 v = convex->vertices[i] * xf.scale;
+      glm::vec2 v = convex->shape->vertices[i] * xf.scale;
       out[i] = center + rotate(v, c, s);
     }
     return n;
@@ -66,6 +74,80 @@ inline glm::vec2 polyCentroid(const glm::vec2* v, int n) {
   return c / static_cast<float>(n);
 }
 
+// A box or convex shape in world space: CCW vertices, the normal of the edge
+// starting at each vertex, the centroid, a bounding circle around the shape
+// origin, and the corner rounding. Built once per body per step and shared
+// by every pair the body is in; keep one around to reuse its storage.
+struct WorldPoly {
+  std::vector<glm::vec2> v;
+  std::vector<glm::vec2> n;
+  glm::vec2 centroid{ 0.f };
+  glm::vec2 origin{ 0.f };
+  float     radius = 0.f;
+  float     skin   = 0.f;
+  int       count  = 0;
+};
+
+inline void makeWorldPoly(WorldPoly& out, const TransformComponent& xf,
+                          float c, float s,
+                          const BoxCollider* box, const ConvexCollider* convex) {
+  out.count = hullCount(box, convex);
+  out.skin  = 0.f;
+  if (out.count < 2) return;
+  if (out.v.size() < static_cast<size_t>(out.count)) {
+    out.v.resize(out.count);
+    out.n.resize(out.count);
+  }
+  getWorldPoly(out.v.data(), xf, c, s, box, convex);
+
+  // Mirroring flips the winding; put it back so every routine sees CCW.
+  const glm::vec2 signs = box ? box->halfExtents * xf.scale : xf.scale;
+  if (signs.x * signs.y < 0.f)
+    std::reverse(out.v.begin(), out.v.begin() + out.count);
+
+  // Rotating the local normals is only exact under uniform positive scale;
+  // anything else goes back to the world edges.
+  const bool uniform = xf.scale.x == xf.scale.y && xf.scale.x > 0.f;
+  if (box && uniform && box->halfExtents.x > 0.f && box->halfExtents.y > 0.f) {
+    glm::vec2 ax{ c, s }, ay{ -s, c };
+    out.n[0] = -ay;
+    out.n[1] =  ax;
+    out.n[2] =  ay;
+    out.n[3] = -ax;
+  } else if (convex && uniform) {
+    for (int i = 0; i < out.count; ++i)
+      out.n[i] = rotate(convex->shape->normals[i], c, s);
+  } else {
+    for (int i = 0; i < out.count; ++i)
+      out.n[i] = faceNormal(out.v.data(), out.count, i);
+  }
+
+  const float maxScale = std::max(std::abs(xf.scale.x), std::abs(xf.scale.y));
+  if (box) {
+    out.origin   = worldCenter(xf, c, s, box->offset);
+    out.centroid = out.origin;
+    out.radius   = glm::length(box->halfExtents) * maxScale;
+  } else {
+    out.origin   = worldCenter(xf, c, s, convex->offset);
+    out.centroid = out.origin + rotate(convex->shape->centroid * xf.scale, c, s);
+    out.radius   = convex->shape->radius * maxScale;
+    out.skin     = convex->shape->rounding * maxScale;
+  }
+}
+
+// Bounding circles apart; cheaper than any separating-axis pass.
+inline bool boundsApart(const WorldPoly& a, const glm::vec2& center, float r) {
+  glm::vec2 d = center - a.origin;
+  float reach = a.radius + r;
+  return glm::dot(d, d) > reach * reach;
+}
+
+inline void makeWorldPoly(WorldPoly& out, const TransformComponent& xf,
+                          const BoxCollider* box, const ConvexCollider* convex) {
+  makeWorldPoly(out, xf, std::cos(xf.rotation), std::sin(xf.rotation),
+                box, convex);
+}
+
 inline glm::vec2 worldToLocal(const TransformComponent& xf,
                                const glm::vec2& worldPt) {
   float c = std::cos(xf.rotation), s = std::sin(xf.rotation);
@@ -73,61 +155,95 @@ inline glm::vec2 worldToLocal(const TransformComponent& xf,
   return rotateInv(d, c, s);
 }
 
-inline std::optional<ContactConstraint>
-circleVsCircle(entt::entity eA, const TransformComponent& xfA,
-               const CircleCollider& cA,
-               entt::entity eB, const TransformComponent& xfB,
-               const CircleCollider& cB)
-{
-  glm::vec2 posA = worldCenter(xfA, cA.offset);
-  glm::vec2 posB = worldCenter(xfB, cB.offset);
-  float rA = cA.radius * std::max(xfA.scale.x, xfA.scale.y);
-  float rB = cB.radius * std::max(xfB.scale.x, xfB.scale.y);
+// A body as the contact routines see it: entity, transform and the cos/sin
+// of its rotation, so contact points go local without any trig.
+struct BodyFrame {
+  entt::entity              entity = entt::null;
+  const TransformComponent* xf     = nullptr;
+  float                     c      = 1.f;
+  float                     s      = 0.f;
 
+  glm::vec2 toLocal(const glm::vec2& p) const {
+    return rotateInv(p - xf->position, c, s);
+  }
+  glm::vec2 toWorld(const glm::vec2& offset) const {
+    return worldCenter(*xf, c, s, offset);
+  }
+};
+
+// Anchors for a point lying on one body's surface. Touching points anchor
+// both bodies there. A speculative point (negative penetration) anchors the
+// other body across the gap, so the position pass sees the real separation.
+inline void anchorPoint(ContactPoint& pt, const BodyFrame& A,
+                        const BodyFrame& B, const glm::vec2& normal,
+                        bool onA) {
+  const glm::vec2 gap = std::min(pt.penetration, 0.f) * normal;
+  pt.localA = A.toLocal(onA ? pt.position : pt.position + gap);
+  pt.localB = B.toLocal(onA ? pt.position - gap : pt.position);
+}
+
+// Contact between two circles given in world space; false if they are
+// margin or more apart. Shared by circleVsCircle and the batched circle
+// kernel.
+inline bool circleContact(const BodyFrame& A, const glm::vec2& posA, float rA,
+                          const BodyFrame& B, const glm::vec2& posB, float rB,
+                          ContactConstraint& out, float margin = 0.f)
+{
   glm::vec2 diff = posB - posA;
   float dist2 = glm::dot(diff, diff);
   float rSum  = rA + rB;
-  if (dist2 >= rSum * rSum) return std::nullopt;
+  if (dist2 >= (rSum + margin) * (rSum + margin)) return false;
 
   float dist = std::sqrt(dist2);
 
-  ContactConstraint cc;
-  cc.bodyA = eA;
-  cc.bodyB = eB;
-  cc.normal = (dist > 1e-6f) ? diff / dist : glm::vec2{ 0.f, 1.f };
-  cc.pointCount = 1;
+  out.bodyA = A.entity;
+  out.bodyB = B.entity;
+  out.normal = (dist > 1e-6f) ? diff / dist : glm::vec2{ 0.f, 1.f };
+  out.pointCount = 1;
 
-  auto& pt = cc.points[0];
-  pt.position    = posA + cc.normal * rA;
+  auto& pt = out.points[0];
+  pt.position    = posA + out.normal * rA;
   pt.penetration = rSum - dist;
-  pt.localA      = worldToLocal(xfA, pt.position);
-  pt.localB      = worldToLocal(xfB, pt.position);
   pt.feature     = { 0, ContactFeature::VERTEX, 0, ContactFeature::VERTEX };
+  anchorPoint(pt, A, B, out.normal, true);
+  return true;
+}
 
-  return cc;
+inline float circleRadius(const TransformComponent& xf, const CircleCollider& c) {
+  return c.radius * std::max(xf.scale.x, xf.scale.y);
 }
 
-inline std::optional<ContactConstraint>
-circleVsPoly(entt::entity eCircle, const TransformComponent& xfC,
-             const CircleCollider& cc,
-             entt::entity ePoly, const TransformComponent& xfP,
-             const BoxCollider* box, const ConvexCollider* convex,
-             bool flipped)
+inline bool circleVsCircle(const BodyFrame& A, const CircleCollider& cA,
+                           const BodyFrame& B, const CircleCollider& cB,
+                           ContactConstraint& out, float margin = 0.f)
 {
-  glm::vec2 polyV[MAX_POLY];
-  int nP = getWorldPoly(polyV, xfP, box, convex);
-  if (nP < 3) return std::nullopt;
+  return circleContact(A, A.toWorld(cA.offset), circleRadius(*A.xf, cA),
+                       B, B.toWorld(cB.offset), circleRadius(*B.xf, cB), out,
+                       margin);
+}
 
-  glm::vec2 center = worldCenter(xfC, cc.offset);
-  float radius = cc.radius * std::max(xfC.scale.x, xfC.scale.y);
+// With flipped set the polygon becomes body A of the contact. A rounded
+// polygon is its core grown by poly.skin, so the circle just gets bigger.
+inline bool circleVsPoly(const BodyFrame& C, const CircleCollider& cc,
+                         const BodyFrame& P, const WorldPoly& poly,
+                         bool flipped, ContactConstraint& out,
+                         float margin = 0.f)
+{
+  const glm::vec2* polyV = poly.v.data();
+  const int nP = poly.count;
+  if (nP < 2) return false;
+
+  glm::vec2 center = C.toWorld(cc.offset);
+  float circleR = circleRadius(*C.xf, cc);
+  if (boundsApart(poly, center, circleR + margin)) return false;
+  float radius = circleR + poly.skin;
 
   float bestSep  = -1e20f;
   int   bestEdge = 0;
   bool  allInside = true;
 
   for (int i = 0; i < nP; ++i) {
-    glm::vec2 n = faceNormal(polyV, nP, i);
-    float sep = glm::dot(center - polyV[i], n);
+    float sep = glm::dot(center - polyV[i], poly.n[i]);
     if (sep > 0.f) allInside = false;
     if (sep > bestSep) {
       bestSep  = sep;
@@ -135,22 +251,23 @@ circleVsPoly(entt::entity eCircle, const TransformComponent& xfC,
     }
   }
 
+  const BodyFrame& A = flipped ? P : C;
+  const BodyFrame& B = flipped ? C : P;
+
   if (allInside) {
-    glm::vec2 n = faceNormal(polyV, nP, bestEdge);
-    ContactConstraint result;
-    result.bodyA = flipped ? ePoly   : eCircle;
-    result.bodyB = flipped ? eCircle : ePoly;
-    result.normal = flipped ? n : -n;
-    result.pointCount = 1;
-
-    auto& pt = result.points[0];
-    pt.position    = center - n * bestSep;
+    glm::vec2 n = poly.n[bestEdge];
+    out.bodyA = A.entity;
+    out.bodyB = B.entity;
+    out.normal = flipped ? n : -n;
+    out.pointCount = 1;
+
+    auto& pt = out.points[0];
+    pt.position    = center - n * (bestSep - poly.skin);
     pt.penetration = radius - bestSep;
-    pt.localA      = worldToLocal(flipped ? xfP : xfC, pt.position);
-    pt.localB      = worldToLocal(flipped ? xfC : xfP, pt.position);
-    pt.feature     = { static_cast<uint8_t>(bestEdge), ContactFeature::FACE,
+    pt.feature     = { static_cast<uint16_t>(bestEdge), ContactFeature::FACE,
                        0, ContactFeature::VERTEX };
-    return result;
+    anchorPoint(pt, A, B, out.normal, flipped);
+    return true;
   }
 
   float bestDist2 = std::numeric_limits<float>::max();
@@ -183,26 +300,24 @@ circleVsPoly(entt::entity eCircle, const TransformComponent& xfC,
   }
 
   float dist = std::sqrt(bestDist2);
-  if (dist >= radius) return std::nullopt;
+  if (dist >= radius + margin) return false;
 
   glm::vec2 normal = (dist > 1e-6f)
     ? (center - bestPoint) / dist
     : glm::vec2{ 0.f, 1.f };
 
-  ContactConstraint result;
-  result.bodyA  = flipped ? ePoly   : eCircle;
-  result.bodyB  = flipped ? eCircle : ePoly;
-  result.normal = flipped ? normal : -normal;
-  result.pointCount = 1;
+  out.bodyA  = A.entity;
+  out.bodyB  = B.entity;
+  out.normal = flipped ? normal : -normal;
+  out.pointCount = 1;
 
-  auto& pt = result.points[0];
-  pt.position    = bestPoint;
+  auto& pt = out.points[0];
+  pt.position    = bestPoint + normal * poly.skin;
   pt.penetration = radius - dist;
-  pt.localA      = worldToLocal(flipped ? xfP : xfC, pt.position);
-  pt.localB      = worldToLocal(flipped ? xfC : xfP, pt.position);
-  pt.feature     = { static_cast<uint8_t>(bestIdx), bestType,
+  pt.feature     = { static_cast<uint16_t>(bestIdx), bestType,
                      0, ContactFeature::VERTEX };
-  return result;
+  anchorPoint(pt, A, B, out.normal, flipped);
+  return true;
 }
 
 namespace detail {
@@ -212,32 +327,72 @@ struct ClipVertex {
   ContactFeature cf;
 };
 
-inline float findAxisLeastPenetration(const glm::vec2* a, int nA,
-                                      const glm::vec2* b, int nB,
+constexpr int kScanVertices = 12;
+
+// Index of the vertex of p deepest along -dir.
+inline int deepestVertex(const WorldPoly& p, const glm::vec2& dir) {
+  int best = 0;
+  float minDot = glm::dot(p.v[0], dir);
+  for (int i = 1; i < p.count; ++i) {
+    float d = glm::dot(p.v[i], dir);
+    if (d < minDot) {
+      minDot = d;
+      best   = i;
+    }
+  }
+  return best;
+}
+
+// a's faces come in CCW order, so b's deepest vertex against each one only
+// ever moves forward around b: one scan for the first face, then a short
+// walk per face. O(a.count + b.count) for the whole pass. Small polygons
+// just scan, which is cheaper below a dozen or so vertices.
+inline float findAxisLeastPenetration(const WorldPoly& a, const WorldPoly& b,
                                       int& bestFace) {
   float bestSep = -1e20f;
   bestFace = 0;
-  for (int i = 0; i < nA; ++i) {
-    glm::vec2 n = faceNormal(a, nA, i);
-    float minDot = 1e20f;
-    for (int j = 0; j < nB; ++j) {
-      float d = glm::dot(b[j] - a[i], n);
-      if (d < minDot) minDot = d;
+  const int nB = b.count;
+  if (nB <= kScanVertices) {
+    for (int i = 0; i < a.count; ++i) {
+      const glm::vec2& n = a.n[i];
+      float minDot = 1e20f;
+      for (int j = 0; j < nB; ++j) {
+        float d = glm::dot(b.v[j] - a.v[i], n);
+        if (d < minDot) minDot = d;
+      }
+      if (minDot > bestSep) {
+        bestSep  = minDot;
+        bestFace = i;
+      }
     }
-    if (minDot > bestSep) {
-      bestSep  = minDot;
+    return bestSep;
+  }
+
+  int j = deepestVertex(b, a.n[0]);
+  for (int i = 0; i < a.count; ++i) {
+    const glm::vec2& n = a.n[i];
+    float minDot = glm::dot(b.v[j], n);
+    for (int step = 1; step < nB; ++step) {
+      int k = j + 1 == nB ? 0 : j + 1;
+      float d = glm::dot(b.v[k], n);
+      if (d > minDot) break;
+      minDot = d;
+      j = k;
+    }
+    float sep = glm::dot(b.v[j] - a.v[i], n);
+    if (sep > bestSep) {
+      bestSep  = sep;
       bestFace = i;
     }
   }
   return bestSep;
 }
 
-inline int findIncidentEdge(const glm::vec2* v, int n,
-                             const glm::vec2& refNormal) {
+inline int findIncidentEdge(const WorldPoly& p, const glm::vec2& refNormal) {
   float minDot = 1e20f;
   int best = 0;
-  for (int i = 0; i < n; ++i) {
-    float d = glm::dot(faceNormal(v, n, i), refNormal);
+  for (int i = 0; i < p.count; ++i) {
+    float d = glm::dot(p.n[i], refNormal);
     if (d < minDot) {
       minDot = d;
       best   = i;
@@ -248,7 +403,7 @@ inline int findIncidentEdge(const glm::vec2* v, int n,
 
 inline int clipSegment(ClipVertex out[2], const ClipVertex in[2],
                         const glm::vec2& normal, float offset,
-                        uint8_t clipEdge, bool refIsA) {
+                        uint16_t clipEdge, bool refIsA) {
   int count = 0;
   float d0 = glm::dot(normal, in[0].v) - offset;
   float d1 = glm::dot(normal, in[1].v) - offset;
@@ -277,113 +432,818 @@ inline int clipSegment(ClipVertex out[2], const ClipVertex in[2],
   return count;
 }
 
+// B's face must beat A's by this margin to become the reference, which
+// keeps the choice from flickering between nearly equal faces.
+constexpr float kRefRelTol = 0.95f;
+constexpr float kRefAbsTol = 0.005f;
+
+// Reference face (rv1 -> rv2, edge refE of refN) and incident edge
+// (iv1 -> iv2, edge iEdge of incN) picked by the separating axis pass.
+struct FaceClip {
+  glm::vec2 rv1, rv2, refNormal;
+  glm::vec2 iv1, iv2;
+  int       refE, refN;
+  int       iEdge, incN;
+  bool      refIsA;
+};
+
+// Clips the incident edge to the reference face's side planes and keeps the
+// points below the face, or less than margin above it. Shared by every
+// polygon routine so feature ids agree between them. Rounded shapes pass
+// their skins: points count as touching that much sooner and sit on the
+// incident shape's surface.
+inline bool clipManifold(const BodyFrame& fA, const BodyFrame& fB,
+                         const FaceClip& f, const glm::vec2& dirAtoB,
+                         ContactConstraint& out,
+                         float refSkin = 0.f, float incSkin = 0.f,
+                         float margin = 0.f) {
+  const uint16_t refE = static_cast<uint16_t>(f.refE);
+  const uint16_t inc0 = static_cast<uint16_t>(f.iEdge);
+  const uint16_t inc1 = static_cast<uint16_t>((f.iEdge + 1) % f.incN);
+
+  ClipVertex incSeg[2];
+  incSeg[0].v = f.iv1;
+  incSeg[1].v = f.iv2;
+
+  if (f.refIsA) {
+    incSeg[0].cf = { refE, ContactFeature::FACE, inc0, ContactFeature::VERTEX };
+    incSeg[1].cf = { refE, ContactFeature::FACE, inc1, ContactFeature::VERTEX };
+  } else {
+    incSeg[0].cf = { inc0, ContactFeature::VERTEX, refE, ContactFeature::FACE };
+    incSeg[1].cf = { inc1, ContactFeature::VERTEX, refE, ContactFeature::FACE };
+  }
+
+  // Face normals are the edge direction turned clockwise.
+  const glm::vec2 tangent{ -f.refNormal.y, f.refNormal.x };
+
+  uint16_t sideIdx1 = refE;
+  uint16_t sideIdx2 = static_cast<uint16_t>((f.refE + 1) % f.refN);
+
+  float sideOffset1 = glm::dot(tangent, f.rv1);
+  float sideOffset2 = glm::dot(tangent, f.rv2);
+
+  ClipVertex clip1[2];
+  int n1 = clipSegment(clip1, incSeg, -tangent, -sideOffset1, sideIdx1, f.refIsA);
+  if (n1 < 2) return false;
+
+  ClipVertex clip2[2];
+  int n2 = clipSegment(clip2, clip1, tangent, sideOffset2, sideIdx2, f.refIsA);
+  if (n2 < 2) return false;
+
+  float refFaceOffset = glm::dot(f.refNormal, f.rv1) + refSkin + incSkin;
+
+  out.bodyA  = fA.entity;
+  out.bodyB  = fB.entity;
+  out.normal = (glm::dot(f.refNormal, dirAtoB) >= 0.f) ? f.refNormal
+                                                       : -f.refNormal;
+  out.pointCount = 0;
+
+  for (int i = 0; i < n2 && out.pointCount < 2; ++i) {
+    float sep = glm::dot(f.refNormal, clip2[i].v) - refFaceOffset;
+    if (sep <= margin) {
+      auto& pt = out.points[out.pointCount];
+      pt.position    = clip2[i].v - f.refNormal * incSkin;
+      pt.penetration = -sep;
+      pt.feature     = clip2[i].cf;
+      anchorPoint(pt, fA, fB, out.normal, !f.refIsA);
+      out.pointCount++;
+    }
+  }
+
+  return out.pointCount > 0;
 }
 
-inline std::optional<ContactConstraint>
-polyVsPoly(entt::entity eA, const TransformComponent& xfA,
-           const BoxCollider* boxA, const ConvexCollider* convexA,
-           entt::entity eB, const TransformComponent& xfB,
-           const BoxCollider* boxB, const ConvexCollider* convexB)
-{
-  glm::vec2 vA[MAX_POLY], vB[MAX_POLY];
-  int nA = getWorldPoly(vA, xfA, boxA, convexA);
-  int nB = getWorldPoly(vB, xfB, boxB, convexB);
-  if (nA < 3 || nB < 3) return std::nullopt;
+// Closest points between the cores of two polygons, skins ignored. GJK:
+// every iteration costs one support scan per polygon and it seldom needs
+// more than a few, so large hulls stay linear.
+struct CoreDistance {
+  glm::vec2 pointA{ 0.f };
+  glm::vec2 pointB{ 0.f };
+  float     distance = 0.f;
+  int       indexA   = 0;       // closest vertices when vertexPair is set
+  int       indexB   = 0;
+  bool      vertexPair = false;
+  bool      overlap    = false; // cores intersect; points are meaningless
+};
 
-  int faceA, faceB;
-  float sepA = detail::findAxisLeastPenetration(vA, nA, vB, nB, faceA);
-  if (sepA > 0.f) return std::nullopt;
-
-  float sepB = detail::findAxisLeastPenetration(vB, nB, vA, nA, faceB);
-  if (sepB > 0.f) return std::nullopt;
-
-  const float kRelTol = 0.95f;
-  const float kAbsTol = 0.005f; 
-  bool useA = sepA >= sepB * kRelTol + kAbsTol;
-
-  const glm::vec2* refV;
-  int               refN, refE;
-  const glm::vec2* incV;
-  int               incN;
-  bool              refIsA;
-
-  if (useA) {
-    refV = vA; refN = nA; refE = faceA;
-    incV = vB; incN = nB;
-    refIsA = true;
+struct SimplexVertex {
+  glm::vec2 wA{ 0.f }, wB{ 0.f }, w{ 0.f };   // support points and w = wB - wA
+  float     a  = 0.f;                         // barycentric weight
+  int       iA = 0, iB = 0;
+};
+
+inline int supportIndex(const WorldPoly& p, const glm::vec2& d) {
+  int best = 0;
+  float maxDot = glm::dot(p.v[0], d);
+  for (int i = 1; i < p.count; ++i) {
+    float dd = glm::dot(p.v[i], d);
+    if (dd > maxDot) {
+      maxDot = dd;
+      best   = i;
+    }
+  }
+  return best;
+}
+
+inline float cross2(const glm::vec2& a, const glm::vec2& b) {
+  return a.x * b.y - a.y * b.x;
+}
+
+// Reduces the simplex to the feature closest to the origin and sets the
+// weights of what is left.
+inline void solveSimplex2(SimplexVertex* v, int& count) {
+  const glm::vec2 e12 = v[1].w - v[0].w;
+  const float d12_2 = -glm::dot(v[0].w, e12);
+  if (d12_2 <= 0.f) {
+    v[0].a = 1.f;
+    count = 1;
+    return;
+  }
+  const float d12_1 = glm::dot(v[1].w, e12);
+  if (d12_1 <= 0.f) {
+    v[0] = v[1];
+    v[0].a = 1.f;
+    count = 1;
+    return;
+  }
+  const float inv = 1.f / (d12_1 + d12_2);
+  v[0].a = d12_1 * inv;
+  v[1].a = d12_2 * inv;
+  count = 2;
+}
+
+inline void solveSimplex3(SimplexVertex* v, int& count) {
+  const glm::vec2 w1 = v[0].w, w2 = v[1].w, w3 = v[2].w;
+
+  const glm::vec2 e12 = w2 - w1;
+  const float d12_1 = glm::dot(w2, e12);
+  const float d12_2 = -glm::dot(w1, e12);
+
+  const glm::vec2 e13 = w3 - w1;
+  const float d13_1 = glm::dot(w3, e13);
+  const float d13_2 = -glm::dot(w1, e13);
+
+  const glm::vec2 e23 = w3 - w2;
+  const float d23_1 = glm::dot(w3, e23);
+  const float d23_2 = -glm::dot(w2, e23);
+
+  const float n123 = cross2(e12, e13);
+  const float d123_1 = n123 * cross2(w2, w3);
+  const float d123_2 = n123 * cross2(w3, w1);
+  const float d123_3 = n123 * cross2(w1, w2);
+
+  if (d12_2 <= 0.f && d13_2 <= 0.f) {
+    v[0].a = 1.f;
+    count = 1;
+  } else if (d12_1 > 0.f && d12_2 > 0.f && d123_3 <= 0.f) {
+    const float inv = 1.f / (d12_1 + d12_2);
+    v[0].a = d12_1 * inv;
+    v[1].a = d12_2 * inv;
+    count = 2;
+  } else if (d13_1 > 0.f && d13_2 > 0.f && d123_2 <= 0.f) {
+    const float inv = 1.f / (d13_1 + d13_2);
+    v[0].a = d13_1 * inv;
+    v[2].a = d13_2 * inv;
+    v[1] = v[2];
+    count = 2;
+  } else if (d12_1 <= 0.f && d23_2 <= 0.f) {
+    v[0] = v[1];
+    v[0].a = 1.f;
+    count = 1;
+  } else if (d13_1 <= 0.f && d23_1 <= 0.f) {
+    v[0] = v[2];
+    v[0].a = 1.f;
+    count = 1;
+  } else if (d23_1 > 0.f && d23_2 > 0.f && d123_1 <= 0.f) {
+    const float inv = 1.f / (d23_1 + d23_2);
+    v[1].a = d23_1 * inv;
+    v[2].a = d23_2 * inv;
+    v[0] = v[2];
+    count = 2;
   } else {
-    refV = vB; refN = nB; refE = faceB;
-    incV = vA; incN = nA;
-    refIsA = false;
+    const float inv = 1.f / (d123_1 + d123_2 + d123_3);
+    v[0].a = d123_1 * inv;
+    v[1].a = d123_2 * inv;
+    v[2].a = d123_3 * inv;
+    count = 3;
   }
+}
+
+inline CoreDistance coreDistance(const WorldPoly& A, const WorldPoly& B,
+                                 int maxIterations = 32) {
+  SimplexVertex v[3];
+  int count = 1;
+  v[0].iA = 0;
+  v[0].iB = 0;
+  v[0].wA = A.v[0];
+  v[0].wB = B.v[0];
+  v[0].w  = v[0].wB - v[0].wA;
+  v[0].a  = 1.f;
 
-  glm::vec2 refNormal = faceNormal(refV, refN, refE);
+  CoreDistance out;
+  bool grown = false;
+  for (int iter = 0; iter < maxIterations; ++iter) {
+    int savedA[3], savedB[3];
+    const int savedCount = count;
+    for (int i = 0; i < count; ++i) {
+      savedA[i] = v[i].iA;
+      savedB[i] = v[i].iB;
+    }
+
+    if (count == 2)      solveSimplex2(v, count);
+    else if (count == 3) solveSimplex3(v, count);
+    grown = false;
+    if (count == 3) break;
 
-  int iEdge = detail::findIncidentEdge(incV, incN, refNormal);
+    glm::vec2 d;
+    if (count == 1) {
+      d = -v[0].w;
+    } else {
+      const glm::vec2 e12 = v[1].w - v[0].w;
+      d = cross2(e12, -v[0].w) > 0.f ? glm::vec2{ -e12.y, e12.x }
+                                     : glm::vec2{ e12.y, -e12.x };
+    }
+    // The origin sits on the simplex: the cores touch or overlap.
+    if (glm::dot(d, d) < 1e-12f) break;
 
-  detail::ClipVertex incSeg[2];
-  incSeg[0].v = incV[iEdge];
-  incSeg[1].v = incV[(iEdge + 1) % incN];
+    SimplexVertex& nv = v[count];
+    nv.iA = supportIndex(A, -d);
+    nv.iB = supportIndex(B, d);
+    nv.wA = A.v[nv.iA];
+    nv.wB = B.v[nv.iB];
+    nv.w  = nv.wB - nv.wA;
 
-  if (refIsA) {
-    incSeg[0].cf = { static_cast<uint8_t>(refE), ContactFeature::FACE,
-                     static_cast<uint8_t>(iEdge), ContactFeature::VERTEX };
-    incSeg[1].cf = { static_cast<uint8_t>(refE), ContactFeature::FACE,
-                     static_cast<uint8_t>((iEdge + 1) % incN), ContactFeature::VERTEX };
+    bool duplicate = false;
+    for (int i = 0; i < savedCount; ++i) {
+      if (savedA[i] == nv.iA && savedB[i] == nv.iB) {
+        duplicate = true;
+        break;
+      }
+    }
+    if (duplicate) break;
+    ++count;
+    grown = true;
+  }
+
+  // Out of iterations right after a new support point: its weight was
+  // never set, and a triangle does not hold the origin until solved.
+  if (grown) {
+    if (count == 2)      solveSimplex2(v, count);
+    else if (count == 3) solveSimplex3(v, count);
+  }
+
+  if (count == 3) {
+    out.overlap = true;
+    return out;
+  }
+  if (count == 1) {
+    out.pointA     = v[0].wA;
+    out.pointB     = v[0].wB;
+    out.indexA     = v[0].iA;
+    out.indexB     = v[0].iB;
+    out.vertexPair = true;
   } else {
-    incSeg[0].cf = { static_cast<uint8_t>(iEdge), ContactFeature::VERTEX,
-                     static_cast<uint8_t>(refE), ContactFeature::FACE };
-    incSeg[1].cf = { static_cast<uint8_t>((iEdge + 1) % incN), ContactFeature::VERTEX,
-                     static_cast<uint8_t>(refE), ContactFeature::FACE };
+    out.pointA = v[0].a * v[0].wA + v[1].a * v[1].wA;
+    out.pointB = v[0].a * v[0].wB + v[1].a * v[1].wB;
+  }
+  out.distance = glm::length(out.pointB - out.pointA);
+  out.overlap  = out.distance < 1e-6f;
+  return out;
+}
+
+// Cores closer than this go through the separating axis pass instead.
+constexpr float kCoreTouch = 1e-4f;
+
+// Rounded polygons whose cores are apart but whose skins come within margin.
+// Face contacts clip like polyVsPoly; corner contacts get the single closest
+// point.
+inline bool roundedManifold(const BodyFrame& fA, const WorldPoly& A,
+                            const BodyFrame& fB, const WorldPoly& B,
+                            const CoreDistance& cd, ContactConstraint& out,
+                            float margin = 0.f) {
+  const glm::vec2 n = (cd.pointB - cd.pointA) / cd.distance;
+
+  if (!cd.vertexPair) {
+    int faceA = 0, faceB = 0;
+    float alignA = -2.f, alignB = -2.f;
+    for (int i = 0; i < A.count; ++i) {
+      float d = glm::dot(A.n[i], n);
+      if (d > alignA) { alignA = d; faceA = i; }
+    }
+    for (int i = 0; i < B.count; ++i) {
+      float d = -glm::dot(B.n[i], n);
+      if (d > alignB) { alignB = d; faceB = i; }
+    }
+
+    const bool useA = alignA + kRefAbsTol >= alignB;
+    const WorldPoly& ref = useA ? A : B;
+    const WorldPoly& inc = useA ? B : A;
+
+    FaceClip f;
+    f.refIsA    = useA;
+    f.refE      = useA ? faceA : faceB;
+    f.refN      = ref.count;
+    f.refNormal = ref.n[f.refE];
+    f.rv1       = ref.v[f.refE];
+    f.rv2       = ref.v[(f.refE + 1) % ref.count];
+    f.incN      = inc.count;
+    f.iEdge     = findIncidentEdge(inc, f.refNormal);
+    f.iv1       = inc.v[f.iEdge];
+    f.iv2       = inc.v[(f.iEdge + 1) % inc.count];
+    if (clipManifold(fA, fB, f, n, out, ref.skin, inc.skin, margin))
+      return true;
   }
 
-  glm::vec2 rv1 = refV[refE];
-  glm::vec2 rv2 = refV[(refE + 1) % refN];
-  glm::vec2 tangent = glm::normalize(rv2 - rv1);
+  out.bodyA      = fA.entity;
+  out.bodyB      = fB.entity;
+  out.normal     = n;
+  out.pointCount = 1;
+
+  auto& pt = out.points[0];
+  pt.position    = cd.pointA + n * A.skin;
+  pt.penetration = A.skin + B.skin - cd.distance;
+  pt.feature     = { static_cast<uint16_t>(cd.indexA), ContactFeature::VERTEX,
+                     static_cast<uint16_t>(cd.indexB), ContactFeature::VERTEX };
+  anchorPoint(pt, fA, fB, n, true);
+  return true;
+}
+
+}
 
-  uint8_t sideIdx1 = static_cast<uint8_t>(refE);
-  uint8_t sideIdx2 = static_cast<uint8_t>((refE + 1) % refN);
+// Sharp polygons go straight to the separating axis pass. Rounded ones
+// first measure their cores with GJK: apart means a skin contact (or none),
+// overlapping falls back to the separating axes with the skins added on.
+inline bool polyVsPoly(const BodyFrame& fA, const WorldPoly& A,
+                       const BodyFrame& fB, const WorldPoly& B,
+                       ContactConstraint& out, float margin = 0.f)
+{
+  if (A.count < 2 || B.count < 2) return false;
+  if (boundsApart(A, B.origin, B.radius + margin)) return false;
 
-  float sideOffset1 = glm::dot(tangent, rv1);
-  float sideOffset2 = glm::dot(tangent, rv2);
+  const float skin  = A.skin + B.skin;
+  const float reach = skin + margin;
+  if (skin > 0.f) {
+    detail::CoreDistance cd = detail::coreDistance(A, B);
+    if (!cd.overlap) {
+      if (cd.distance >= reach) return false;
+      if (cd.distance > detail::kCoreTouch)
+        return detail::roundedManifold(fA, A, fB, B, cd, out, margin);
+    }
+  }
 
-  detail::ClipVertex clip1[2];
-  int n1 = detail::clipSegment(clip1, incSeg, -tangent, -sideOffset1, sideIdx1, refIsA);
-  if (n1 < 2) return std::nullopt;
+  int faceA, faceB;
+  float sepA = detail::findAxisLeastPenetration(A, B, faceA);
+  if (sepA > reach) return false;
 
-  detail::ClipVertex clip2[2];
-  int n2 = detail::clipSegment(clip2, clip1, tangent, sideOffset2, sideIdx2, refIsA);
-  if (n2 < 2) return std::nullopt;
+  float sepB = detail::findAxisLeastPenetration(B, A, faceB);
+  if (sepB > reach) return false;
 
-  float refFaceOffset = glm::dot(refNormal, rv1);
+  bool useA = sepA >= sepB * detail::kRefRelTol + detail::kRefAbsTol;
 
-  glm::vec2 cA = polyCentroid(vA, nA);
-  glm::vec2 cB = polyCentroid(vB, nB);
-  glm::vec2 dirAtoB = cB - cA;
-  glm::vec2 resultNormal = (glm::dot(refNormal, dirAtoB) >= 0.f)
-                            ? refNormal : -refNormal;
+  const WorldPoly& ref  = useA ? A : B;
+  const WorldPoly& inc  = useA ? B : A;
 
-  ContactConstraint result;
-  result.bodyA  = eA;
-  result.bodyB  = eB;
-  result.normal = resultNormal;
-  result.pointCount = 0;
+  detail::FaceClip f;
+  f.refIsA    = useA;
+  f.refE      = useA ? faceA : faceB;
+  f.refN      = ref.count;
+  f.refNormal = ref.n[f.refE];
+  f.rv1       = ref.v[f.refE];
+  f.rv2       = ref.v[(f.refE + 1) % ref.count];
+  f.incN      = inc.count;
+  f.iEdge     = detail::findIncidentEdge(inc, f.refNormal);
+  f.iv1       = inc.v[f.iEdge];
+  f.iv2       = inc.v[(f.iEdge + 1) % inc.count];
 
-  for (int i = 0; i < n2 && result.pointCount < 2; ++i) {
-    float sep = glm::dot(refNormal, clip2[i].v) - refFaceOffset;
-    if (sep <= 0.f) {
-      auto& pt = result.points[result.pointCount];
-      pt.position    = clip2[i].v;
-      pt.penetration = -sep;
-      pt.localA      = worldToLocal(xfA, pt.position);
-      pt.localB      = worldToLocal(xfB, pt.position);
-      pt.feature     = clip2[i].cf;
-      result.pointCount++;
+  return detail::clipManifold(fA, fB, f, B.centroid - A.centroid, out,
+                              ref.skin, inc.skin, margin);
+}
+
+// An oriented box in world space: center, unit axes and positive half
+// extents. Corners and faces are numbered as getWorldPoly numbers them, so
+// feature ids match polyVsPoly.
+struct WorldBox {
+  glm::vec2 center{ 0.f };
+  glm::vec2 ax{ 1.f, 0.f };
+  glm::vec2 ay{ 0.f, 1.f };
+  glm::vec2 half{ 0.f };
+
+  glm::vec2 corner(int i) const {
+    float sx = (i == 1 || i == 2) ? half.x : -half.x;
+    float sy = (i >= 2)           ? half.y : -half.y;
+    return center + sx * ax + sy * ay;
+  }
+  glm::vec2 normal(int i) const {
+    switch (i) {
+      case 0:  return -ay;
+      case 1:  return  ax;
+      case 2:  return  ay;
+      default: return -ax;
+    }
+  }
+  float faceExtent(int i) const { return (i & 1) ? half.x : half.y; }
+};
+
+// False for boxes with zero or mirrored extents; those stay on polyVsPoly.
+inline bool makeWorldBox(WorldBox& out, const BodyFrame& f,
+                         const BoxCollider& box) {
+  out.half = box.halfExtents * f.xf->scale;
+  if (!(out.half.x > 0.f && out.half.y > 0.f)) return false;
+  out.center = f.toWorld(box.offset);
+  out.ax     = { f.c, f.s };
+  out.ay     = { -f.s, f.c };
+  return true;
+}
+
+namespace detail {
+
+// findAxisLeastPenetration for boxes, from the extents instead of the
+// sixteen vertex dot products.
+inline float boxAxisLeastPenetration(const WorldBox& a, const WorldBox& b,
+                                     int& bestFace) {
+  const glm::vec2 d = b.center - a.center;
+  float bestSep = -1e20f;
+  bestFace = 0;
+  for (int i = 0; i < 4; ++i) {
+    glm::vec2 n = a.normal(i);
+    float reachB = b.half.x * std::abs(glm::dot(n, b.ax)) +
+                   b.half.y * std::abs(glm::dot(n, b.ay));
+    float sep = glm::dot(d, n) - a.faceExtent(i) - reachB;
+    if (sep > bestSep) {
+      bestSep  = sep;
+      bestFace = i;
+    }
+  }
+  return bestSep;
+}
+
+inline int boxIncidentEdge(const WorldBox& b, const glm::vec2& refNormal) {
+  float minDot = 1e20f;
+  int best = 0;
+  for (int i = 0; i < 4; ++i) {
+    float d = glm::dot(b.normal(i), refNormal);
+    if (d < minDot) {
+      minDot = d;
+      best   = i;
+    }
+  }
+  return best;
+}
+
+}
+
+inline bool boxVsBox(const BodyFrame& fA, const WorldBox& A,
+                     const BodyFrame& fB, const WorldBox& B,
+                     ContactConstraint& out, float margin = 0.f)
+{
+  int faceA, faceB;
+  float sepA = detail::boxAxisLeastPenetration(A, B, faceA);
+  if (sepA > margin) return false;
+
+  float sepB = detail::boxAxisLeastPenetration(B, A, faceB);
+  if (sepB > margin) return false;
+
+  bool useA = sepA >= sepB * detail::kRefRelTol + detail::kRefAbsTol;
+  const WorldBox& ref = useA ? A : B;
+  const WorldBox& inc = useA ? B : A;
+
+  detail::FaceClip f;
+  f.refIsA    = useA;
+  f.refE      = useA ? faceA : faceB;
+  f.refN      = 4;
+  f.refNormal = ref.normal(f.refE);
+  f.rv1       = ref.corner(f.refE);
+  f.rv2       = ref.corner((f.refE + 1) & 3);
+  f.incN      = 4;
+  f.iEdge     = detail::boxIncidentEdge(inc, f.refNormal);
+  f.iv1       = inc.corner(f.iEdge);
+  f.iv2       = inc.corner((f.iEdge + 1) & 3);
+
+  return detail::clipManifold(fA, fB, f, B.center - A.center, out,
+                              0.f, 0.f, margin);
+}
+
+// Overlap masks for four pairs at once, lane i in bit i. Both tests are
+// exact, so batch callers only run the manifold code for lanes that pass.
+inline int circlesOverlap4(const float ax[4], const float ay[4],
+                           const float bx[4], const float by[4],
+                           const float rSum[4]) {
+  Float4 dx = Float4::load(bx) - Float4::load(ax);
+  Float4 dy = Float4::load(by) - Float4::load(ay);
+  Float4 r  = Float4::load(rSum);
+  return mask(dx * dx + dy * dy < r * r);
+}
+
+// Oriented boxes in lane form: center, cos/sin of the rotation and
+// non-negative half extents.
+struct BoxLanes {
+  float cx[4], cy[4], c[4], s[4], hx[4], hy[4];
+
+  void set(int lane, const glm::vec2& center, float cosR, float sinR,
+           const glm::vec2& half) {
+    cx[lane] = center.x;  cy[lane] = center.y;
+    c[lane]  = cosR;      s[lane]  = sinR;
+    hx[lane] = std::abs(half.x);
+    hy[lane] = std::abs(half.y);
+  }
+};
+
+// Separating axis test on the four face normals, with each lane's boxes
+// counting as overlapping up to margin apart. The small slack keeps exactly
+// touching boxes on the manifold path, matching polyVsPoly.
+inline int boxesOverlap4(const BoxLanes& A, const BoxLanes& B,
+                         const float margin[4]) {
+  auto abs4 = [](Float4 x) { return max(x, -x); };
+  const Float4 cA = Float4::load(A.c), sA = Float4::load(A.s);
+  const Float4 cB = Float4::load(B.c), sB = Float4::load(B.s);
+  const Float4 hAx = Float4::load(A.hx), hAy = Float4::load(A.hy);
+  const Float4 hBx = Float4::load(B.hx), hBy = Float4::load(B.hy);
+  const Float4 tx = Float4::load(B.cx) - Float4::load(A.cx);
+  const Float4 ty = Float4::load(B.cy) - Float4::load(A.cy);
+
+  // Relative rotation: |cos| and |sin| of angle B - A.
+  const Float4 k = abs4(cA * cB + sA * sB);
+  const Float4 m = abs4(cA * sB - sA * cB);
+  const Float4 slack(1.0001f), eps(1e-6f);
+  const Float4 gap = Float4::load(margin);
+
+  auto within = [&](Float4 dist, Float4 reach) {
+    return abs4(dist) <= (reach + gap) * slack + eps;
+  };
+  Float4 hit = within(tx * cA + ty * sA,   hAx + hBx * k + hBy * m);
+  hit = hit &  within(ty * cA - tx * sA,   hAy + hBx * m + hBy * k);
+  hit = hit &  within(tx * cB + ty * sB,   hBx + hAx * k + hAy * m);
+  hit = hit &  within(ty * cB - tx * sB,   hBy + hAx * m + hAy * k);
+  return mask(hit);
+}
+
+// B's pose in A's frame plus the normal in A's frame; A and B are the
+// contact's bodyA and bodyB.
+inline ManifoldPose manifoldPose(const BodyFrame& A, const BodyFrame& B,
+                                 const glm::vec2& normal) {
+  ManifoldPose p;
+  p.relPosition = A.toLocal(B.xf->position);
+  p.relRotation = B.xf->rotation - A.xf->rotation;
+  p.localNormal = rotateInv(normal, A.c, A.s);
+  return p;
+}
+
+inline bool poseWithin(const ManifoldPose& pose, const BodyFrame& A,
+                       const BodyFrame& B, float linearTol, float angularTol) {
+  glm::vec2 d = A.toLocal(B.xf->position) - pose.relPosition;
+  float     r = B.xf->rotation - A.xf->rotation - pose.relRotation;
+  return glm::dot(d, d) <= linearTol * linearTol && std::abs(r) <= angularTol;
+}
+
+// Carries last step's manifold forward without colliding: the normal turns
+// with A and each penetration follows the anchors along it. A touching
+// point's anchors coincided, so it moves by their drift; a speculative
+// point's anchors span the gap, so they give the separation outright. The
+// point then moves to the vertex side and is anchored again. False once a
+// touching point has opened up, since the manifold may be changing shape,
+// or once a point is margin or more apart; cc then needs a full collide.
+inline bool refreshManifold(const BodyFrame& A, const BodyFrame& B,
+                            ContactConstraint& cc, float margin = 0.f) {
+  cc.normal = rotate(cc.pose.localNormal, A.c, A.s);
+  for (int i = 0; i < cc.pointCount; ++i) {
+    ContactPoint& pt = cc.points[i];
+    const bool touching = pt.penetration >= 0.f;
+    glm::vec2 wA = A.toWorld(pt.localA);
+    glm::vec2 wB = B.toWorld(pt.localB);
+    pt.penetration = std::max(pt.penetration, 0.f)
+                   - glm::dot(wB - wA, cc.normal);
+    if ((touching && pt.penetration < 0.f) || pt.penetration < -margin)
+      return false;
+    const bool onB = pt.feature.typeB == ContactFeature::VERTEX;
+    pt.position = onB ? wB : wA;
+    anchorPoint(pt, A, B, cc.normal, !onB);
+  }
+  return true;
+}
+
+// Any collider as a GJK core: polygons as makeWorldPoly builds them, circles
+// as their center with the radius for skin.
+inline void makeCorePoly(WorldPoly& out, const TransformComponent& xf,
+                         float c, float s, const CircleCollider* circle,
+                         const BoxCollider* box, const ConvexCollider* convex) {
+  if (!circle) {
+    makeWorldPoly(out, xf, c, s, box, convex);
+    return;
+  }
+  if (out.v.empty()) {
+    out.v.resize(1);
+    out.n.resize(1);
+  }
+  out.count    = 1;
+  out.v[0]     = worldCenter(xf, c, s, circle->offset);
+  out.n[0]     = { 0.f, 1.f };
+  out.centroid = out.v[0];
+  out.origin   = out.v[0];
+  out.radius   = circleRadius(xf, *circle);
+  out.skin     = out.radius;
+}
+
+// A body's motion over one step: origin and rotation go linearly from the
+// 0 values to the 1 values.
+struct Sweep {
+  glm::vec2 p0{ 0.f }, p1{ 0.f };
+  float     a0 = 0.f,  a1 = 0.f;
+};
+
+struct TimeOfImpact {
+  float     t = 1.f;
+  glm::vec2 point{ 0.f };    // on the moving shape's surface
+  glm::vec2 normal{ 0.f };   // from the moving shape toward the fixed one
+};
+
+// Conservative advancement of a moving core toward a fixed one: each round
+// moves forward by the time the current gap cannot close in, given the
+// sweep's linear motion and reach, the farthest surface point from the body
+// origin. build(WorldPoly&, const TransformComponent&, float c, float s)
+// makes the moving core at a pose; xf supplies everything the sweep does
+// not. Stops within a quarter of target short of target, at t = 0 for a
+// core left there by an earlier impact that is still closing in. False if
+// the cores never come that close or already overlap; overlap is the
+// discrete contact's.
+template<typename Build>
+inline bool timeOfImpact(Build&& build, const TransformComponent& xf,
+                         const Sweep& sweep, float reach, const WorldPoly& fixed,
+                         float target, int maxIterations, WorldPoly& moving,
+                         TimeOfImpact& out) {
+  const glm::vec2 dp = sweep.p1 - sweep.p0;
+  const float     da = sweep.a1 - sweep.a0;
+  const float tolerance = 0.25f * target;
+
+  TransformComponent x = xf;
+  float t = 0.f;
+  for (int iter = 0; iter <= maxIterations; ++iter) {
+    x.position = sweep.p0 + t * dp;
+    x.rotation = sweep.a0 + t * da;
+    build(moving, x, std::cos(x.rotation), std::sin(x.rotation));
+
+    const detail::CoreDistance cd = detail::coreDistance(moving, fixed);
+    if (cd.overlap) return false;
+    const float gap = cd.distance - moving.skin - fixed.skin;
+    const glm::vec2 n = (cd.pointB - cd.pointA) / cd.distance;
+    const float closing = glm::dot(dp, n) + std::abs(da) * reach;
+
+    // Out of rounds, t is still short of the fixed core; stop there.
+    if (gap < target + tolerance || iter == maxIterations) {
+      if (iter == 0 && (gap < 0.f || closing <= 0.f)) return false;
+      out.t      = t;
+      out.normal = n;
+      out.point  = cd.pointA + n * moving.skin;
+      return true;
+    }
+
+    if (closing <= 0.f) return false;
+    t += (gap - target) / closing;
+    if (t >= 1.f) return false;
+  }
+  return false;
+}
+
+// Inside the core, or within skin of its boundary.
+inline bool containsPoint(const WorldPoly& poly, const glm::vec2& p) {
+  bool  inside = poly.count >= 3;
+  float best2  = std::numeric_limits<float>::max();
+  for (int i = 0; i < poly.count; ++i) {
+    const glm::vec2& a = poly.v[i];
+    if (glm::dot(p - a, poly.n[i]) > 0.f) inside = false;
+    if (poly.skin > 0.f) {
+      glm::vec2 e = poly.v[(i + 1) % poly.count] - a;
+      float len2 = glm::dot(e, e);
+      float t = len2 > 1e-12f ? glm::clamp(glm::dot(p - a, e) / len2, 0.f, 1.f) : 0.f;
+      glm::vec2 q = p - (a + t * e);
+      best2 = std::min(best2, glm::dot(q, q));
+    }
+  }
+  return inside || (poly.skin > 0.f && best2 <= poly.skin * poly.skin);
+}
+
+inline bool testPoint(const TransformComponent& xf, const CircleCollider* circle,
+                      const BoxCollider* box, const ConvexCollider* convex,
+                      const glm::vec2& p) {
+  if (circle) {
+    glm::vec2 d = p - worldCenter(xf, circle->offset);
+    float r = circle->radius * std::max(xf.scale.x, xf.scale.y);
+    return glm::dot(d, d) <= r * r;
+  }
+
+  WorldPoly poly;
+  makeWorldPoly(poly, xf, box, convex);
+  if (poly.count < 2) return false;
+  return containsPoint(poly, p);
+}
+
+// Segment p1 -> p2 against a rounded polygon: every core edge pushed out by
+// the skin, plus a circle at every corner.
+inline bool rayCastRounded(const WorldPoly& poly, const glm::vec2& p1,
+                           const glm::vec2& p2, float maxFraction,
+                           float& fraction, glm::vec2& normal) {
+  if (poly.count < 2 || containsPoint(poly, p1)) return false;
+
+  const glm::vec2 d = p2 - p1;
+  const float     r = poly.skin;
+  const float     a = glm::dot(d, d);
+  if (a < 1e-12f) return false;
+
+  float best = maxFraction;
+  bool  hit  = false;
+  for (int i = 0; i < poly.count; ++i) {
+    const glm::vec2& v0 = poly.v[i];
+    const glm::vec2& n  = poly.n[i];
+
+    float denom = glm::dot(n, d);
+    if (denom < 0.f) {
+      glm::vec2 face = v0 + r * n;
+      float t = glm::dot(n, face - p1) / denom;
+      if (t >= 0.f && t <= best) {
+        glm::vec2 e = poly.v[(i + 1) % poly.count] - v0;
+        float u = glm::dot(p1 + t * d - face, e);
+        if (u >= 0.f && u <= glm::dot(e, e)) {
+          best   = t;
+          normal = n;
+          hit    = true;
+        }
+      }
+    }
+
+    glm::vec2 m = p1 - v0;
+    float b    = glm::dot(m, d);
+    float disc = b * b - a * (glm::dot(m, m) - r * r);
+    if (disc < 0.f) continue;
+    float t = -(b + std::sqrt(disc)) / a;
+    if (t >= 0.f && t <= best) {
+      best   = t;
+      normal = glm::normalize(m + t * d);
+      hit    = true;
+    }
+  }
+
+  if (hit) fraction = best;
+  return hit;
+}
+
+// Segment p1 -> p2 against the shape, clipped to [0, maxFraction]. Segments
+// starting inside the shape do not hit it.
+inline bool rayCast(const TransformComponent& xf, const CircleCollider* circle,
+                    const BoxCollider* box, const ConvexCollider* convex,
+                    const glm::vec2& p1, const glm::vec2& p2, float maxFraction,
+                    float& fraction, glm::vec2& normal) {
+  const glm::vec2 d = p2 - p1;
+
+  if (circle) {
+    glm::vec2 center = worldCenter(xf, circle->offset);
+    float r = circle->radius * std::max(xf.scale.x, xf.scale.y);
+    glm::vec2 m = p1 - center;
+    float c = glm::dot(m, m) - r * r;
+    if (c <= 0.f) return false;
+
+    float a = glm::dot(d, d);
+    float b = glm::dot(m, d);
+    float disc = b * b - a * c;
+    if (a < 1e-12f || disc < 0.f) return false;
+
+    float t = -(b + std::sqrt(disc)) / a;
+    if (t < 0.f || t > maxFraction) return false;
+    fraction = t;
+    normal   = glm::normalize(m + t * d);
+    return true;
+  }
+
+  WorldPoly poly;
+  makeWorldPoly(poly, xf, box, convex);
+  if (poly.skin > 0.f)
+    return rayCastRounded(poly, p1, p2, maxFraction, fraction, normal);
+
+  const glm::vec2* v = poly.v.data();
+  const int        n = poly.count;
+  if (n < 3) return false;
+
+  float lower = 0.f, upper = maxFraction;
+  int   index = -1;
+
+  for (int i = 0; i < n; ++i) {
+    const glm::vec2& nrm = poly.n[i];
+    float num   = glm::dot(nrm, v[i] - p1);
+    float denom = glm::dot(nrm, d);
+
+    if (denom == 0.f) {
+      if (num < 0.f) return false;
+    } else if (denom < 0.f && num < lower * denom) {
+      lower = num / denom;
+      index = i;
+    } else if (denom > 0.f && num < upper * denom) {
+      upper = num / denom;
     }
+    if (upper < lower) return false;
   }
 
-  if (result.pointCount == 0) return std::nullopt;
-  return result;
+  if (index < 0) return false;
+  fraction = lower;
+  normal   = poly.n[index];
+  return true;
 }
 
 }
@@ -0,0 +1,108 @@
+#pragma once
+#include <entt/entt.hpp>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+// Broadphase pairs that live across steps. Each pair keeps its slot for as
+// long as it exists, so later stages can index per-pair state by slot. The
+// lookup map is only touched when a pair is added or removed.
+//
+// A slot freed this step may be handed out again in the same step; consumers
+// should apply removed() before added().
+class PairCache {
+public:
+  static constexpr uint32_t kNullPair = std::numeric_limits<uint32_t>::max();
+
+  struct Pair {
+    entt::entity a       = entt::null;
+    entt::entity b       = entt::null;
+    int32_t      proxyA  = -1;
+    int32_t      proxyB  = -1;
+    uint32_t     genA    = 0;
+    uint32_t     genB    = 0;
+    bool         staticB = false;
+    uint32_t     stamp   = 0;
+  };
+
+  // Returns the pair's slot and whether it was created by this call.
+  std::pair<uint32_t, bool> add(entt::entity a, entt::entity b) {
+    auto [it, inserted] = m_lookup.try_emplace(key(a, b), kNullPair);
+    if (!inserted) return { it->second, false };
+
+    uint32_t slot;
+    if (!m_free.empty()) {
+      slot = m_free.back();
+      m_free.pop_back();
+    } else {
+      slot = static_cast<uint32_t>(m_pairs.size());
+      m_pairs.emplace_back();
+      m_livePos.push_back(0);
+    }
+    it->second    = slot;
+    m_pairs[slot] = Pair{ a, b };
+
+    m_livePos[slot] = static_cast<uint32_t>(m_live.size());
+    m_live.push_back(slot);
+    m_added.push_back(slot);
+    return { slot, true };
+  }
+
+  void remove(uint32_t slot) {
+    Pair& p = m_pairs[slot];
+    m_lookup.erase(key(p.a, p.b));
+    p.a = p.b = entt::null;
+
+    uint32_t pos  = m_livePos[slot];
+    uint32_t last = m_live.back();
+    m_live[pos]     = last;
+    m_livePos[last] = pos;
+    m_live.pop_back();
+
+    m_free.push_back(slot);
+    m_removed.push_back(slot);
+  }
+
+  uint32_t find(entt::entity a, entt::entity b) const {
+    auto it = m_lookup.find(key(a, b));
+    return it == m_lookup.end() ? kNullPair : it->second;
+  }
+
+  void clear() {
+    while (!m_live.empty()) remove(m_live.back());
+  }
+
+  // Forgets the previous step's deltas.
+  void beginStep() {
+    m_added.clear();
+    m_removed.clear();
+  }
+
+  Pair&       operator[](uint32_t slot)       { return m_pairs[slot]; }
+  const Pair& operator[](uint32_t slot) const { return m_pairs[slot]; }
+
+  const std::vector<uint32_t>& live()    const { return m_live; }
+  const std::vector<uint32_t>& added()   const { return m_added; }
+  const std::vector<uint32_t>& removed() const { return m_removed; }
+
+  size_t size()     const { return m_live.size(); }
+  size_t capacity() const { return m_pairs.size(); }
+
+private:
+  static uint64_t key(entt::entity a, entt::entity b) {
+    auto lo = static_cast<uint32_t>(a);
+    auto hi = static_cast<uint32_t>(b);
+    if (lo > hi) std::swap(lo, hi);
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+  }
+
+  std::vector<Pair>                      m_pairs;
+  std::vector<uint32_t>                  m_livePos;
+  std::vector<uint32_t>                  m_live;
+  std::vector<uint32_t>                  m_free;
+  std::vector<uint32_t>                  m_added;
+  std::vector<uint32_t>                  m_removed;
+  std::unordered_map<uint64_t, uint32_t> m_lookup;
+};
@@ -1,9 +1,15 @@
 #pragma once
+#include "components/physics_components.hpp"
 #include <entt/entt.hpp>
+#include <glm/glm.hpp>
 #include <vector>
 #include <memory>
 #include <string>
 
+struct AABB;
+struct RayHit;
+struct RayInput;
+
 class PhysicsSystem {
 public:
   virtual ~PhysicsSystem() = default;
@@ -43,6 +49,23 @@ public:
   void init(entt::registry& reg);
   void update(entt::registry& reg, float dt);
 
+  void queryAABB(const entt::registry& reg, const AABB& box,
+                 std::vector<entt::entity>& out,
+                 const CollisionFilter& filter = {}) const;
+  void queryPoint(const entt::registry& reg, const glm::vec2& point,
+                  std::vector<entt::entity>& out,
+                  const CollisionFilter& filter = {}) const;
+  bool rayCastClosest(const entt::registry& reg, const glm::vec2& p1,
+                      const glm::vec2& p2, RayHit& hit,
+                      const CollisionFilter& filter = {}) const;
+  void rayCastAll(const entt::registry& reg, const glm::vec2& p1,
+                  const glm::vec2& p2, std::vector<RayHit>& hits,
+                  const CollisionFilter& filter = {}) const;
+  size_t rayCastBatch(const entt::registry& reg,
+                      const std::vector<RayInput>& rays,
+                      std::vector<RayHit>& hits,
+                      const CollisionFilter& filter = {}) const;
+
   void  setFixedTimestep(float dt) { m_fixedTimestep = dt; }
   float getFixedTimestep() const   { return m_fixedTimestep; }
 
@@ -1,4 +1,6 @@
 #include "physicsSystem.hpp"
+#include "query.hpp"
+#include "rayBatch.hpp"
 
 void PhysicsWorld::init(entt::registry& reg) {
   for (auto& sys : m_systems)
@@ -20,3 +22,34 @@ void PhysicsWorld::update(entt::registry& reg, float dt) {
     m_accumulator -= m_fixedTimestep;
   }
 }
+
+void PhysicsWorld::queryAABB(const entt::registry& reg, const AABB& box,
+                             std::vector<entt::entity>& out,
+                             const CollisionFilter& filter) const {
+  ::queryAABB(reg, box, filter, out);
+}
+
+void PhysicsWorld::queryPoint(const entt::registry& reg, const glm::vec2& point,
+                              std::vector<entt::entity>& out,
+                              const CollisionFilter& filter) const {
+  ::queryPoint(reg, point, filter, out);
+}
+
+bool PhysicsWorld::rayCastClosest(const entt::registry& reg, const glm::vec2& p1,
+                                  const glm::vec2& p2, RayHit& hit,
+                                  const CollisionFilter& filter) const {
+  return ::rayCastClosest(reg, p1, p2, filter, hit);
+}
+
+void PhysicsWorld::rayCastAll(const entt::registry& reg, const glm::vec2& p1,
+                              const glm::vec2& p2, std::vector<RayHit>& hits,
+                              const CollisionFilter& filter) const {
+  ::rayCastAll(reg, p1, p2, filter, hits);
+}
+
+size_t PhysicsWorld::rayCastBatch(const entt::registry& reg,
+                                  const std::vector<RayInput>& rays,
+                                  std::vector<RayHit>& hits,
+                                  const CollisionFilter& filter) const {
+  return ::rayCastBatch(reg, rays, filter, hits);
+}
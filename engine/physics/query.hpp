@@ -0,0 +1,184 @@
+#pragma once
+#include "broadphase.hpp"
+#include "narrowphase.hpp"
+#include "components/transform.hpp"
+#include "components/physics_components.hpp"
+#include <glm/glm.hpp>
+#include <entt/entt.hpp>
+#include <vector>
+#include <algorithm>
+
+// World queries against the broadphase. Static bodies always come from the
+// static tree; moving bodies come from the dynamic tree in tree mode and from
+// their cached WorldAABB otherwise. Bounds are as of the last collision step,
+// the exact shape tests use the current transforms. A body is reported when
+// shouldCollide(filter, body filter) holds.
+
+struct RayHit {
+  entt::entity entity   = entt::null;
+  glm::vec2    point{0.f};
+  glm::vec2    normal{0.f};
+  float        fraction = 0.f;
+};
+
+namespace query_detail {
+
+struct Shape {
+  const TransformComponent* xf     = nullptr;
+  const CircleCollider*     circle = nullptr;
+  const BoxCollider*        box    = nullptr;
+  const ConvexCollider*     convex = nullptr;
+};
+
+inline bool fetch(const entt::registry& reg, entt::entity e,
+                  const CollisionFilter& filter, Shape& out) {
+  if (!reg.valid(e)) return false;
+  const auto* rb = reg.try_get<RigidBody2D>(e);
+  out.xf = reg.try_get<TransformComponent>(e);
+  if (!rb || !out.xf || !shouldCollide(filter, rb->filter)) return false;
+  out.circle = reg.try_get<CircleCollider>(e);
+  out.box    = reg.try_get<BoxCollider>(e);
+  out.convex = reg.try_get<ConvexCollider>(e);
+  return out.circle || out.box || out.convex;
+}
+
+// fn(entt::entity) for every body whose bounds overlap box.
+template<typename Fn>
+void forEachCandidate(const entt::registry& reg, const AABB& box, Fn&& fn) {
+  const auto* bp = reg.ctx().find<Broadphase>();
+  if (bp) {
+    bp->staticTree().query(box, [&](int32_t id) {
+      fn(bp->staticTree().entity(id));
+      return true;
+    });
+  }
+
+  if (bp && bp->mode == BroadphaseMode::DynamicTree) {
+    bp->tree().query(box, [&](int32_t id) {
+      fn(bp->tree().entity(id));
+      return true;
+    });
+    return;
+  }
+
+  auto view = reg.view<WorldAABB>(entt::exclude<StaticBroadphaseProxy>);
+  for (auto [e, world] : view.each()) {
+    if (world.aabb.overlaps(box)) fn(e);
+  }
+}
+
+// fn(entt::entity, float maxFraction) -> float, with DynamicTree::rayCast's
+// clipping rules.
+template<typename Fn>
+void forEachRayCandidate(const entt::registry& reg, const glm::vec2& p1,
+                         const glm::vec2& p2, float& maxFraction, Fn&& fn) {
+  const auto* bp = reg.ctx().find<Broadphase>();
+  bool stopped = false;
+  auto visit = [&](entt::entity e) {
+    float value = fn(e, maxFraction);
+    if (value == 0.f) stopped = true;
+    else if (value > 0.f) maxFraction = std::min(maxFraction, value);
+    return value;
+  };
+
+  if (bp) {
+    bp->staticTree().rayCast(p1, p2, maxFraction, [&](int32_t id, float) {
+      return visit(bp->staticTree().entity(id));
+    });
+    if (stopped) return;
+  }
+
+  if (bp && bp->mode == BroadphaseMode::DynamicTree) {
+    bp->tree().rayCast(p1, p2, maxFraction, [&](int32_t id, float) {
+      return visit(bp->tree().entity(id));
+    });
+    return;
+  }
+
+  AABB segment = AABB::combine({ p1, p1 }, { p2, p2 });
+  auto view = reg.view<WorldAABB>(entt::exclude<StaticBroadphaseProxy>);
+  for (auto [e, world] : view.each()) {
+    if (!world.aabb.overlaps(segment)) continue;
+    visit(e);
+    if (stopped) return;
+  }
+}
+
+} // namespace query_detail
+
+// Bodies whose world AABB overlaps box.
+inline void queryAABB(const entt::registry& reg, const AABB& box,
+                      const CollisionFilter& filter,
+                      std::vector<entt::entity>& out) {
+  out.clear();
+  query_detail::forEachCandidate(reg, box, [&](entt::entity e) {
+    query_detail::Shape s;
+    if (!query_detail::fetch(reg, e, filter, s)) return;
+    AABB bounds;
+    if (s.circle)     bounds = computeCircleAABB(*s.xf, *s.circle);
+    else if (s.box)   bounds = computeBoxAABB(*s.xf, *s.box);
+    else              bounds = computeConvexAABB(*s.xf, *s.convex);
+    if (bounds.overlaps(box)) out.push_back(e);
+  });
+}
+
+// Bodies whose shape contains point.
+inline void queryPoint(const entt::registry& reg, const glm::vec2& point,
+                       const CollisionFilter& filter,
+                       std::vector<entt::entity>& out) {
+  out.clear();
+  query_detail::forEachCandidate(reg, { point, point }, [&](entt::entity e) {
+    query_detail::Shape s;
+    if (!query_detail::fetch(reg, e, filter, s)) return;
+    if (narrowphase::testPoint(*s.xf, s.circle, s.box, s.convex, point))
+      out.push_back(e);
+  });
+}
+
+// Closest body hit by the segment p1 -> p2.
+inline bool rayCastClosest(const entt::registry& reg, const glm::vec2& p1,
+                           const glm::vec2& p2, const CollisionFilter& filter,
+                           RayHit& hit) {
+  bool found = false;
+  float maxFraction = 1.f;
+  query_detail::forEachRayCandidate(reg, p1, p2, maxFraction,
+    [&](entt::entity e, float maxF) -> float {
+      query_detail::Shape s;
+      if (!query_detail::fetch(reg, e, filter, s)) return -1.f;
+      float fraction;
+      glm::vec2 normal;
+      if (!narrowphase::rayCast(*s.xf, s.circle, s.box, s.convex,
+                                p1, p2, maxF, fraction, normal))
+        return -1.f;
+      found        = true;
+      hit.entity   = e;
+      hit.fraction = fraction;
+      hit.normal   = normal;
+      hit.point    = p1 + fraction * (p2 - p1);
+      return fraction;
+    });
+  return found;
+}
+
+// Every body hit by the segment p1 -> p2, nearest first.
+inline void rayCastAll(const entt::registry& reg, const glm::vec2& p1,
+                       const glm::vec2& p2, const CollisionFilter& filter,
+                       std::vector<RayHit>& hits) {
+  hits.clear();
+  float maxFraction = 1.f;
+  query_detail::forEachRayCandidate(reg, p1, p2, maxFraction,
+    [&](entt::entity e, float maxF) -> float {
+      query_detail::Shape s;
+      if (!query_detail::fetch(reg, e, filter, s)) return -1.f;
+      RayHit h;
+      if (!narrowphase::rayCast(*s.xf, s.circle, s.box, s.convex,
+                                p1, p2, maxF, h.fraction, h.normal))
+        return -1.f;
+      h.entity = e;
+      h.point  = p1 + h.fraction * (p2 - p1);
+      hits.push_back(h);
+      return -1.f;
+    });
+  std::sort(hits.begin(), hits.end(),
+    [](const RayHit& a, const RayHit& b) { return a.fraction < b.fraction; });
+}
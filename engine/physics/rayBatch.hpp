@@ -0,0 +1,226 @@
+#pragma once
+#include "query.hpp"
+#include "simd.hpp"
+#include <glm/glm.hpp>
+#include <entt/entt.hpp>
+#include <vector>
+#include <cmath>
+#include <cstddef>
+
+// Closest-hit ray casts in bulk. Rays are grouped four at a time into packets
+// that walk the broadphase once; every shape a packet reaches is tested
+// against all four rays with Float4 math. Consecutive rays should be roughly
+// coherent (sensor fans, lidar sweeps) for packets to pay off.
+
+struct RayInput {
+  glm::vec2 origin{0.f};
+  glm::vec2 direction{1.f, 0.f};   // normalized here; zero never hits
+  float     maxDistance = 1.f;
+};
+
+namespace query_detail {
+
+struct RayPacket {
+  Float4 ox, oy, dx, dy, invDx, invDy;
+  float  maxT[4];
+  int    live = 0;
+};
+
+inline RayPacket makePacket(const RayInput* rays, size_t count) {
+  float ox[4] = {}, oy[4] = {}, dx[4] = {}, dy[4] = {}, ix[4], iy[4];
+  RayPacket p;
+  for (int i = 0; i < 4; ++i) {
+    p.maxT[i] = 0.f;
+    const float len = static_cast<size_t>(i) < count
+                    ? glm::length(rays[i].direction) : 0.f;
+    if (len > 0.f && std::isfinite(len)) {
+      const RayInput& r = rays[i];
+      const float scale = r.maxDistance / len;
+      ox[i] = r.origin.x;
+      oy[i] = r.origin.y;
+      dx[i] = r.direction.x * scale;
+      dy[i] = r.direction.y * scale;
+      p.maxT[i] = 1.f;
+      p.live |= 1 << i;
+    }
+    // A large finite inverse keeps 0 * inv out of the slab test.
+    ix[i] = dx[i] != 0.f ? 1.f / dx[i] : 1e30f;
+    iy[i] = dy[i] != 0.f ? 1.f / dy[i] : 1e30f;
+  }
+  p.ox = Float4::load(ox);  p.oy = Float4::load(oy);
+  p.dx = Float4::load(dx);  p.dy = Float4::load(dy);
+  p.invDx = Float4::load(ix);
+  p.invDy = Float4::load(iy);
+  return p;
+}
+
+inline int packetHitsBox(const RayPacket& p, const AABB& b) {
+  Float4 t1x = (Float4(b.min.x) - p.ox) * p.invDx;
+  Float4 t2x = (Float4(b.max.x) - p.ox) * p.invDx;
+  Float4 t1y = (Float4(b.min.y) - p.oy) * p.invDy;
+  Float4 t2y = (Float4(b.max.y) - p.oy) * p.invDy;
+  Float4 tMin = max(max(min(t1x, t2x), min(t1y, t2y)), Float4(0.f));
+  Float4 tMax = min(min(max(t1x, t2x), max(t1y, t2y)), Float4::load(p.maxT));
+  return mask(tMin <= tMax) & p.live;
+}
+
+// Tests the packet against one shape and records hits closer than each
+// ray's current best. poly is scratch storage reused across calls.
+inline void packetVsShape(RayPacket& p, entt::entity e, const Shape& s,
+                          narrowphase::WorldPoly& poly, RayHit* hits) {
+  const Float4 maxT = Float4::load(p.maxT);
+  float t[4];
+  int   hitMask;
+
+  if (s.circle) {
+    glm::vec2 c = narrowphase::worldCenter(*s.xf, s.circle->offset);
+    float r = s.circle->radius * std::max(s.xf->scale.x, s.xf->scale.y);
+
+    Float4 mx = p.ox - Float4(c.x), my = p.oy - Float4(c.y);
+    Float4 cc = mx * mx + my * my - Float4(r * r);
+    Float4 a  = p.dx * p.dx + p.dy * p.dy;
+    Float4 b  = mx * p.dx + my * p.dy;
+    Float4 disc = b * b - a * cc;
+    Float4 tHit = (-b - sqrt(max(disc, Float4(0.f)))) / a;
+
+    hitMask = mask((cc > Float4(0.f)) & (disc >= Float4(0.f)) &
+                   (a > Float4(1e-12f)) & (tHit >= Float4(0.f)) & (tHit <= maxT));
+    hitMask &= p.live;
+    if (!hitMask) return;
+    tHit.store(t);
+
+    float ox[4], oy[4], dx[4], dy[4];
+    p.ox.store(ox); p.oy.store(oy); p.dx.store(dx); p.dy.store(dy);
+    for (int i = 0; i < 4; ++i) {
+      if (!(hitMask & (1 << i))) continue;
+      glm::vec2 o{ ox[i], oy[i] }, d{ dx[i], dy[i] };
+      RayHit& h  = hits[i];
+      h.entity   = e;
+      h.fraction = t[i];
+      h.point    = o + t[i] * d;
+      h.normal   = glm::normalize(h.point - c);
+      p.maxT[i]  = t[i];
+    }
+    return;
+  }
+
+  narrowphase::makeWorldPoly(poly, *s.xf, s.box, s.convex);
+
+  // Rounded shapes are rare enough in ray scenes to go lane by lane.
+  if (poly.skin > 0.f) {
+    float ox[4], oy[4], dx[4], dy[4];
+    p.ox.store(ox); p.oy.store(oy); p.dx.store(dx); p.dy.store(dy);
+    for (int i = 0; i < 4; ++i) {
+      if (!(p.live & (1 << i))) continue;
+      glm::vec2 o{ ox[i], oy[i] }, d{ dx[i], dy[i] }, normal;
+      float fraction;
+      if (!narrowphase::rayCastRounded(poly, o, o + d, p.maxT[i], fraction, normal))
+        continue;
+      RayHit& h  = hits[i];
+      h.entity   = e;
+      h.fraction = fraction;
+      h.point    = o + fraction * d;
+      h.normal   = normal;
+      p.maxT[i]  = fraction;
+    }
+    return;
+  }
+
+  const glm::vec2* v = poly.v.data();
+  const glm::vec2* n = poly.n.data();
+  const int    count = poly.count;
+  if (count < 3) return;
+
+  const Float4 zero(0.f);
+  Float4 lower = zero, upper = maxT, index(-1.f);
+  Float4 valid = zero == zero;
+
+  for (int i = 0; i < count; ++i) {
+    Float4 num = Float4(n[i].x) * (Float4(v[i].x) - p.ox) +
+                 Float4(n[i].y) * (Float4(v[i].y) - p.oy);
+    Float4 den = Float4(n[i].x) * p.dx + Float4(n[i].y) * p.dy;
+
+    valid = andNot((den == zero) & (num < zero), valid);
+    Float4 enter = (den < zero) & (num < lower * den);
+    Float4 exit  = (den > zero) & (num < upper * den);
+    Float4 q = num / den;
+    lower = select(enter, q, lower);
+    index = select(enter, Float4(static_cast<float>(i)), index);
+    upper = select(exit, q, upper);
+  }
+
+  hitMask = mask(valid & (lower <= upper) & (index >= zero) & (lower <= maxT));
+  hitMask &= p.live;
+  if (!hitMask) return;
+  lower.store(t);
+
+  float ox[4], oy[4], dx[4], dy[4], idx[4];
+  p.ox.store(ox); p.oy.store(oy); p.dx.store(dx); p.dy.store(dy);
+  index.store(idx);
+  for (int i = 0; i < 4; ++i) {
+    if (!(hitMask & (1 << i))) continue;
+    RayHit& h  = hits[i];
+    h.entity   = e;
+    h.fraction = t[i];
+    h.point    = glm::vec2{ ox[i], oy[i] } + t[i] * glm::vec2{ dx[i], dy[i] };
+    h.normal   = n[static_cast<int>(idx[i])];
+    p.maxT[i]  = t[i];
+  }
+}
+
+} // namespace query_detail
+
+// hits[i] receives the closest hit of rays[i]; misses keep entt::null. The
+// fraction is along maxDistance, whatever the length of direction. Returns
+// the number of rays that hit something.
+inline size_t rayCastBatch(const entt::registry& reg, const RayInput* rays,
+                           size_t count, const CollisionFilter& filter,
+                           RayHit* hits) {
+  using namespace query_detail;
+  const auto* bp = reg.ctx().find<Broadphase>();
+  const bool useTree = bp && bp->mode == BroadphaseMode::DynamicTree;
+  auto movers = reg.view<WorldAABB>(entt::exclude<StaticBroadphaseProxy>);
+
+  narrowphase::WorldPoly poly;
+  size_t hitCount = 0;
+  for (size_t base = 0; base < count; base += 4) {
+    size_t lanes = std::min<size_t>(4, count - base);
+    RayPacket packet = makePacket(rays + base, lanes);
+    RayHit*   out    = hits + base;
+    for (size_t i = 0; i < lanes; ++i) out[i] = RayHit{};
+
+    auto visit = [&](entt::entity e) {
+      Shape s;
+      if (fetch(reg, e, filter, s)) packetVsShape(packet, e, s, poly, out);
+      return true;
+    };
+    auto nodeTest = [&](const AABB& b) { return packetHitsBox(packet, b) != 0; };
+
+    if (bp) {
+      bp->staticTree().traverse(nodeTest, [&](int32_t id) {
+        return visit(bp->staticTree().entity(id));
+      });
+    }
+    if (useTree) {
+      bp->tree().traverse(nodeTest, [&](int32_t id) {
+        return visit(bp->tree().entity(id));
+      });
+    } else {
+      for (auto [e, world] : movers.each()) {
+        if (packetHitsBox(packet, world.aabb)) visit(e);
+      }
+    }
+
+    for (size_t i = 0; i < lanes; ++i)
+      if (out[i].entity != entt::null) ++hitCount;
+  }
+  return hitCount;
+}
+
+inline size_t rayCastBatch(const entt::registry& reg,
+                           const std::vector<RayInput>& rays,
+                           const CollisionFilter& filter,
+                           std::vector<RayHit>& hits) {
+  hits.resize(rays.size());
+  return rayCastBatch(reg, rays.data(), rays.size(), filter, hits.data());
+}
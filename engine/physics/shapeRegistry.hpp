@@ -0,0 +1,216 @@
+#pragma once
+#include "components/physics_components.hpp"
+#include <glm/glm.hpp>
+#include <entt/entt.hpp>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Owns every ConvexShape in a registry. Identical vertex lists (and rounding)
+// intern to the same shape, so a thousand spawned hexagons share one copy. Vertex and
+// normal data is packed into large blocks. Shapes live as long as the
+// registry does.
+class ShapeRegistry {
+public:
+  // Colliders point into the storage, so the registry may move but not copy.
+  ShapeRegistry() = default;
+  ShapeRegistry(ShapeRegistry&&) = default;
+  ShapeRegistry& operator=(ShapeRegistry&&) = default;
+  ShapeRegistry(const ShapeRegistry&) = delete;
+  ShapeRegistry& operator=(const ShapeRegistry&) = delete;
+
+  // rounding > 0 rounds every corner by that radius; with two vertices the
+  // shape is a capsule.
+  const ConvexShape* intern(const glm::vec2* vertices, size_t count,
+                            float rounding = 0.0f) {
+    m_scratch.assign(vertices, vertices + count);
+    makeCCW(m_scratch);
+    rounding = std::max(rounding, 0.0f);
+
+    const uint64_t h = hash(m_scratch, rounding);
+    auto [first, last] = m_lookup.equal_range(h);
+    for (auto it = first; it != last; ++it) {
+      const ConvexShape* s = it->second;
+      if (s->count == count && s->rounding == rounding &&
+          std::equal(m_scratch.begin(), m_scratch.end(), s->vertices))
+        return s;
+    }
+
+    glm::vec2* data = allocate(2 * count);
+    std::copy(m_scratch.begin(), m_scratch.end(), data);
+
+    ConvexShape& shape = m_shapes.emplace_back();
+    shape.vertices = data;
+    shape.normals  = data + count;
+    shape.count    = static_cast<uint32_t>(count);
+    shape.rounding = rounding;
+    bake(shape, data + count);
+
+    m_lookup.emplace(h, &shape);
+    return &shape;
+  }
+
+  const ConvexShape* intern(const std::vector<glm::vec2>& vertices,
+                            float rounding = 0.0f) {
+    return intern(vertices.data(), vertices.size(), rounding);
+  }
+
+  size_t size() const { return m_shapes.size(); }
+
+private:
+  static constexpr size_t kBlockSize = 4096;
+
+  glm::vec2* allocate(size_t n) {
+    if (n > kBlockSize) {
+      m_large.emplace_back(new glm::vec2[n]);
+      return m_large.back().get();
+    }
+    if (m_blocks.empty() || m_used + n > kBlockSize) {
+      m_blocks.emplace_back(new glm::vec2[kBlockSize]);
+      m_used = 0;
+    }
+    glm::vec2* p = m_blocks.back().get() + m_used;
+    m_used += n;
+    return p;
+  }
+
+  static void makeCCW(std::vector<glm::vec2>& v) {
+    float twiceArea = 0.0f;
+    for (size_t i = 0; i < v.size(); ++i) {
+      const glm::vec2& a = v[i];
+      const glm::vec2& b = v[(i + 1) % v.size()];
+      twiceArea += a.x * b.y - b.x * a.y;
+    }
+    if (twiceArea < 0.0f) std::reverse(v.begin(), v.end());
+  }
+
+  static uint64_t hash(const std::vector<glm::vec2>& v, float rounding) {
+    uint64_t h = 1469598103934665603ull;
+    for (const auto& p : v) {
+      uint32_t bits[2];
+      std::memcpy(bits, &p, sizeof(bits));
+      h = (h ^ bits[0]) * 1099511628211ull;
+      h = (h ^ bits[1]) * 1099511628211ull;
+    }
+    uint32_t bits;
+    std::memcpy(&bits, &rounding, sizeof(bits));
+    return (h ^ bits) * 1099511628211ull;
+  }
+
+  void bake(ConvexShape& s, glm::vec2* normals) {
+    const uint32_t n = s.count;
+    if (n == 0) return;
+
+    float r2 = 0.0f;
+    for (uint32_t i = 0; i < n; ++i) {
+      const glm::vec2& a = s.vertices[i];
+      glm::vec2 edge = s.vertices[(i + 1) % n] - a;
+      float len = std::sqrt(edge.x * edge.x + edge.y * edge.y);
+      normals[i] = len < 1e-8f ? glm::vec2{ 0.0f, 1.0f }
+                               : glm::vec2{ edge.y / len, -edge.x / len };
+      r2 = std::max(r2, a.x * a.x + a.y * a.y);
+    }
+    s.radius = std::sqrt(r2) + s.rounding;
+
+    if (n == 2 && s.rounding > 0.0f) {
+      bakeCapsule(s);
+      return;
+    }
+
+    if (s.rounding > 0.0f && n >= 3) {
+      // Mass of the rounded shape, approximated by pushing each corner out
+      // along its bisector.
+      m_inflated.resize(n);
+      for (uint32_t i = 0; i < n; ++i) {
+        glm::vec2 mid = normals[(i + n - 1) % n] + normals[i];
+        float len = std::sqrt(mid.x * mid.x + mid.y * mid.y);
+        m_inflated[i] = s.vertices[i];
+        if (len > 1e-6f) m_inflated[i] += (1.41421356f * s.rounding / len) * mid;
+      }
+      if (polygonMass(s, m_inflated.data(), n)) return;
+    }
+
+    if (!polygonMass(s, s.vertices, n)) {
+      glm::vec2 centroid{0.0f};
+      for (uint32_t i = 0; i < n; ++i) centroid += s.vertices[i];
+      s.centroid = centroid / static_cast<float>(n);
+    }
+  }
+
+  // Area, centroid and unit inertia of the polygon v; false if it has no
+  // area.
+  static bool polygonMass(ConvexShape& s, const glm::vec2* v, uint32_t n) {
+    if (n < 3) return false;
+    glm::vec2 centroid{0.0f};
+    float area = 0.0f;
+    for (uint32_t i = 0; i < n; ++i) {
+      const glm::vec2& a = v[i];
+      const glm::vec2& b = v[(i + 1) % n];
+      float cross = a.x * b.y - b.x * a.y;
+      area     += cross;
+      centroid += (a + b) * cross;
+    }
+    area *= 0.5f;
+    if (area <= 1e-8f) return false;
+
+    s.centroid = centroid / (6.0f * area);
+    s.area     = area;
+
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < n; ++i) {
+      glm::vec2 a = v[i] - s.centroid;
+      glm::vec2 b = v[(i + 1) % n] - s.centroid;
+      float cross = std::abs(a.x * b.y - b.x * a.y);
+      sum += cross * (glm::dot(a, a) + glm::dot(a, b) + glm::dot(b, b));
+    }
+    s.unitInertia = sum / (6.0f * 2.0f * area);
+    return true;
+  }
+
+  // A box of the segment's length plus two half discs.
+  static void bakeCapsule(ConvexShape& s) {
+    const float pi = 3.14159265f;
+    const float r  = s.rounding;
+    const float L  = glm::length(s.vertices[1] - s.vertices[0]);
+
+    const float boxArea  = 2.0f * r * L;
+    const float halfArea = 0.5f * pi * r * r;
+    const float d        = 4.0f * r / (3.0f * pi);   // half disc centroid offset
+    const float boxI  = boxArea * (L * L + 4.0f * r * r) / 12.0f;
+    const float halfI = halfArea * (0.5f * r * r - d * d) +
+                        halfArea * (0.5f * L + d) * (0.5f * L + d);
+
+    s.centroid    = 0.5f * (s.vertices[0] + s.vertices[1]);
+    s.area        = boxArea + 2.0f * halfArea;
+    s.unitInertia = (boxI + 2.0f * halfI) / s.area;
+  }
+
+  std::deque<ConvexShape>                        m_shapes;
+  std::vector<std::unique_ptr<glm::vec2[]>>      m_blocks;
+  std::vector<std::unique_ptr<glm::vec2[]>>      m_large;
+  size_t                                         m_used = 0;
+  std::unordered_multimap<uint64_t, const ConvexShape*> m_lookup;
+  std::vector<glm::vec2>                         m_scratch;
+  std::vector<glm::vec2>                         m_inflated;
+};
+
+inline const ConvexShape* internConvexShape(entt::registry& reg,
+                                            const std::vector<glm::vec2>& vertices,
+                                            float rounding = 0.0f) {
+  auto* shapes = reg.ctx().find<ShapeRegistry>();
+  if (!shapes) shapes = &reg.ctx().emplace<ShapeRegistry>();
+  return shapes->intern(vertices, rounding);
+}
+
+// A capsule along the local x axis: segment of half length halfLength with
+// the given radius.
+inline const ConvexShape* internCapsuleShape(entt::registry& reg,
+                                             float halfLength, float radius) {
+  return internConvexShape(reg, { { -halfLength, 0.0f }, { halfLength, 0.0f } },
+                           radius);
+}
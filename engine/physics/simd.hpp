@@ -0,0 +1,144 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Four floats processed in lock step. SSE2 when available, plain arrays
+// otherwise; both give the same results. Comparisons return all-ones or
+// all-zero lanes for use with select() and mask().
+struct Float4 {
+#if defined(__SSE2__)
+  __m128 v;
+
+  Float4() = default;
+  Float4(__m128 x) : v(x) {}
+  explicit Float4(float s) : v(_mm_set1_ps(s)) {}
+
+  static Float4 load(const float* p)       { return _mm_loadu_ps(p); }
+  void          store(float* p) const      { _mm_storeu_ps(p, v); }
+  float         operator[](int i) const    { float t[4]; store(t); return t[i]; }
+
+  friend Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+  friend Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+  friend Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+  friend Float4 operator/(Float4 a, Float4 b) { return _mm_div_ps(a.v, b.v); }
+  friend Float4 operator-(Float4 a)           { return _mm_xor_ps(a.v, _mm_set1_ps(-0.f)); }
+
+  friend Float4 operator<(Float4 a, Float4 b)  { return _mm_cmplt_ps(a.v, b.v); }
+  friend Float4 operator<=(Float4 a, Float4 b) { return _mm_cmple_ps(a.v, b.v); }
+  friend Float4 operator>(Float4 a, Float4 b)  { return _mm_cmpgt_ps(a.v, b.v); }
+  friend Float4 operator>=(Float4 a, Float4 b) { return _mm_cmpge_ps(a.v, b.v); }
+  friend Float4 operator==(Float4 a, Float4 b) { return _mm_cmpeq_ps(a.v, b.v); }
+  friend Float4 operator&(Float4 a, Float4 b)  { return _mm_and_ps(a.v, b.v); }
+  friend Float4 operator|(Float4 a, Float4 b)  { return _mm_or_ps(a.v, b.v); }
+
+  friend Float4 min(Float4 a, Float4 b)  { return _mm_min_ps(a.v, b.v); }
+  friend Float4 max(Float4 a, Float4 b)  { return _mm_max_ps(a.v, b.v); }
+  friend Float4 sqrt(Float4 a)           { return _mm_sqrt_ps(a.v); }
+  // To the nearest integer, ties to even.
+  friend Float4 round(Float4 a)          { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a.v)); }
+  friend Float4 andNot(Float4 m, Float4 a) { return _mm_andnot_ps(m.v, a.v); }
+  // Lanes of a where m is set, b elsewhere.
+  friend Float4 select(Float4 m, Float4 a, Float4 b) {
+    return _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v));
+  }
+  // One bit per lane, lane 0 in bit 0.
+  friend int mask(Float4 m) { return _mm_movemask_ps(m.v); }
+#else
+  float v[4];
+
+  Float4() = default;
+  explicit Float4(float s) : v{ s, s, s, s } {}
+
+  static Float4 load(const float* p)    { Float4 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+  void          store(float* p) const   { std::memcpy(p, v, sizeof(v)); }
+  float         operator[](int i) const { return v[i]; }
+
+  template<typename Op>
+  static Float4 map(Float4 a, Float4 b, Op op) {
+    Float4 r;
+    for (int i = 0; i < 4; ++i) r.v[i] = op(a.v[i], b.v[i]);
+    return r;
+  }
+  static float bits(bool b) {
+    uint32_t u = b ? 0xFFFFFFFFu : 0u;
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+  }
+  static uint32_t raw(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+  }
+  static float fromRaw(uint32_t u) {
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+  }
+
+  friend Float4 operator+(Float4 a, Float4 b) { return map(a, b, [](float x, float y) { return x + y; }); }
+  friend Float4 operator-(Float4 a, Float4 b) { return map(a, b, [](float x, float y) { return x - y; }); }
+  friend Float4 operator*(Float4 a, Float4 b) { return map(a, b, [](float x, float y) { return x * y; }); }
+  friend Float4 operator/(Float4 a, Float4 b) { return map(a, b, [](float x, float y) { return x / y; }); }
+  friend Float4 operator-(Float4 a)           { return Float4(0.f) - a; }
+
+  friend Float4 operator<(Float4 a, Float4 b)  { return map(a, b, [](float x, float y) { return bits(x < y); }); }
+  friend Float4 operator<=(Float4 a, Float4 b) { return map(a, b, [](float x, float y) { return bits(x <= y); }); }
+  friend Float4 operator>(Float4 a, Float4 b)  { return map(a, b, [](float x, float y) { return bits(x > y); }); }
+  friend Float4 operator>=(Float4 a, Float4 b) { return map(a, b, [](float x, float y) { return bits(x >= y); }); }
+  friend Float4 operator==(Float4 a, Float4 b) { return map(a, b, [](float x, float y) { return bits(x == y); }); }
+  friend Float4 operator&(Float4 a, Float4 b)  { return map(a, b, [](float x, float y) { return fromRaw(raw(x) & raw(y)); }); }
+  friend Float4 operator|(Float4 a, Float4 b)  { return map(a, b, [](float x, float y) { return fromRaw(raw(x) | raw(y)); }); }
+
+  // Same NaN behaviour as minps/maxps: the second operand wins.
+  friend Float4 min(Float4 a, Float4 b)  { return map(a, b, [](float x, float y) { return x < y ? x : y; }); }
+  friend Float4 max(Float4 a, Float4 b)  { return map(a, b, [](float x, float y) { return x > y ? x : y; }); }
+  friend Float4 sqrt(Float4 a)           { return map(a, a, [](float x, float) { return std::sqrt(x); }); }
+  friend Float4 round(Float4 a)          { return map(a, a, [](float x, float) { return std::nearbyint(x); }); }
+  friend Float4 andNot(Float4 m, Float4 a) { return map(m, a, [](float x, float y) { return fromRaw(~raw(x) & raw(y)); }); }
+  friend Float4 select(Float4 m, Float4 a, Float4 b) {
+    Float4 r;
+    for (int i = 0; i < 4; ++i) r.v[i] = raw(m.v[i]) ? a.v[i] : b.v[i];
+    return r;
+  }
+  friend int mask(Float4 m) {
+    int r = 0;
+    for (int i = 0; i < 4; ++i) r |= (raw(m.v[i]) >> 31) << i;
+    return r;
+  }
+#endif
+};
+
+// Sine and cosine to about 1e-7 for angles within a few turns of zero:
+// reduced to [-pi/4, pi/4] by quarter turns, then the minimax polynomials
+// of the Cephes sinf/cosf.
+inline void sincos(Float4 x, Float4& s, Float4& c) {
+  const Float4 q = round(x * Float4(0.63661977236758134f));   // 2/pi
+  Float4 r = x - q * Float4(1.5703125f);
+  r = r - q * Float4(4.837512969970703125e-4f);
+  r = r - q * Float4(7.54978995489188216e-8f);
+
+  const Float4 r2 = r * r;
+  const Float4 sr = r + r * r2 * (Float4(-1.6666654611e-1f) +
+                    r2 * (Float4(8.3321608736e-3f) + r2 * Float4(-1.9515295891e-4f)));
+  const Float4 cr = Float4(1.f) - Float4(0.5f) * r2 + r2 * r2 *
+                    (Float4(4.166664568298827e-2f) +
+                     r2 * (Float4(-1.388731625493765e-3f) + r2 * Float4(2.443315711809948e-5f)));
+
+  // Quarter turn modulo four, as -2..2 (-1 is the fourth quadrant).
+  const Float4 m = q - Float4(4.f) * round(q * Float4(0.25f));
+  const Float4 one = Float4(1.f), two = Float4(2.f);
+  const Float4 odd   = (m == one) | (m == -one);
+  const Float4 half  = (m == two) | (m == -two);
+  const Float4 sNeg  = half | (m == -one);
+  const Float4 cNeg  = half | (m == one);
+  const Float4 sv = select(odd, cr, sr);
+  const Float4 cv = select(odd, sr, cr);
+  s = select(sNeg, -sv, sv);
+  c = select(cNeg, -cv, cv);
+}
@@ -4,6 +4,9 @@
 #include "../broadphase.hpp"
 #include "../narrowphase.hpp"
 #include "../collisionEvents.hpp"
+#include "../simd.hpp"
+#include "../threadPool.hpp"
+#include "../unionFind.hpp"
 #include "components/transform.hpp"
 #include "components/physics_components.hpp"
 #include <vector>
@@ -11,6 +14,21 @@
 
 class CollisionDetectionSystem : public PhysicsSystem {
 public:
+  // Pairs that already had a contact and whose relative pose is within
+  // these of the one their manifold was built at keep that manifold
+  // instead of colliding again (see narrowphase::refreshManifold).
+  bool  manifoldReuse        = true;
+  float reuseLinearTolerance  = 0.002f;
+  float reuseAngularTolerance = 0.002f;
+
+  // Pairs get contacts once they are within the broadphase contactMargin
+  // plus as far as their bodies could move this step, not just once they
+  // overlap. The solver lets such speculative contacts close but not pass,
+  // so fast bodies stop at thin geometry without a higher step rate. Each
+  // body's share is capped; anything faster should be a bullet.
+  bool  speculativeContacts    = true;
+  float maxSpeculativeDistance = 0.5f;
+
   void init(entt::registry& reg) override {
     if (!reg.ctx().contains<ContactManager>())
       reg.ctx().emplace<ContactManager>();
@@ -18,118 +36,655 @@ public:
       reg.ctx().emplace<CollisionEvents>();
     if (!reg.ctx().contains<CollisionPairTracker>())
       reg.ctx().emplace<CollisionPairTracker>();
+    if (!reg.ctx().contains<Broadphase>())
+      reg.ctx().emplace<Broadphase>();
+    if (!reg.ctx().contains<ThreadPool>())
+      reg.ctx().emplace<ThreadPool>();
+
+    reg.on_destroy<BroadphaseProxy>().connect<&onBroadphaseProxyDestroyed>();
+    reg.on_destroy<StaticBroadphaseProxy>().connect<&onStaticProxyDestroyed>();
+
+    reg.on_construct<CircleCollider>().connect<&invalidateBroadphaseProxy>();
+    reg.on_construct<BoxCollider>().connect<&invalidateBroadphaseProxy>();
+    reg.on_construct<ConvexCollider>().connect<&invalidateBroadphaseProxy>();
+    reg.on_destroy<CircleCollider>().connect<&invalidateBroadphaseProxy>();
+    reg.on_destroy<BoxCollider>().connect<&invalidateBroadphaseProxy>();
+    reg.on_destroy<ConvexCollider>().connect<&invalidateBroadphaseProxy>();
+    reg.on_destroy<RigidBody2D>().connect<&invalidateBroadphaseProxy>();
   }
 
-  void fixedUpdate(entt::registry& reg, float /*fixedDt*/) override {
+  void fixedUpdate(entt::registry& reg, float fixedDt) override {
     auto& cm = reg.ctx().get<ContactManager>();
+    auto& bp = reg.ctx().get<Broadphase>();
+    const bool useTree = bp.mode == BroadphaseMode::DynamicTree;
 
     m_bodies.clear();
     m_bpEntries.clear();
+    m_dynamicEntries.clear();
+    m_newStatics.clear();
+
+    dropStaleStaticProxies(reg);
 
     {
-      auto view = reg.view<TransformComponent, RigidBody2D>();
+      auto view = reg.view<TransformComponent, RigidBody2D>(
+        entt::exclude<StaticBroadphaseProxy>);
       for (auto [e, xf, rb] : view.each()) {
         CircleCollider* cc = reg.try_get<CircleCollider>(e);
         BoxCollider*    bc = reg.try_get<BoxCollider>(e);
         ConvexCollider* cv = reg.try_get<ConvexCollider>(e);
         if (!cc && !bc && !cv) continue;
 
-        m_bodies.push_back({ e, &xf, &rb, cc, bc, cv });
+        // Sleeping bodies keep their bounds and proxies; moving one, or
+        // changing its collider, wakes it.
+        auto* world = reg.try_get<WorldAABB>(e);
+        if (!world) world = &reg.emplace<WorldAABB>(e);
+        if (isAsleep(rb) && !world->matches(xf)) wakeBody(rb);
+        const bool asleep = isAsleep(rb);
+        if (!asleep) world->refresh(xf, cc, bc, cv);
+
+        if (isStatic(rb)) {
+          m_newStatics.push_back({ e, world->aabb });
+          continue;
+        }
+
+        const float ahead = speculativeContacts
+          ? speculativeDistance(xf, rb, world->aabb, fixedDt) : 0.f;
+        const AABB aabb = world->aabb.fattened(ahead);
+
+        m_bodies.push_back({ { e, &xf, world->cosR, world->sinR },
+                             &rb, cc, bc, cv, kNoPoly, ahead });
 
-        AABB aabb;
-        if (cc) aabb = computeCircleAABB(xf, *cc);
-        else if (bc) aabb = computeBoxAABB(xf, *bc);
-        else if (cv) aabb = computeConvexAABB(xf, *cv);
+        BroadphaseEntry entry{ e, aabb.fattened(bp.contactMargin) };
+        if (isDynamic(rb))
+          m_dynamicEntries.push_back(entry);
 
-        m_bpEntries.push_back({ e, aabb.fattened(0.01f) });
+        if (!useTree) {
+          m_bpEntries.push_back(entry);
+          continue;
+        }
+
+        if (auto* proxy = reg.try_get<BroadphaseProxy>(e)) {
+          if (!asleep) bp.updateProxy(proxy->id, aabb);
+        } else
+          reg.emplace<BroadphaseProxy>(e, bp.createProxy(aabb, e));
       }
     }
 
-    sortAndSweep(m_bpEntries, m_pairs);
+    for (auto& ns : m_newStatics) {
+      reg.remove<BroadphaseProxy>(ns.entity);
+      reg.emplace<StaticBroadphaseProxy>(
+        ns.entity, bp.createStaticProxy(ns.aabb, ns.entity),
+        reg.get<TransformComponent>(ns.entity));
+    }
+    bp.rebuildStaticIfDirty();
+
+    if (bp.mode == BroadphaseMode::DynamicTree) {
+      bp.updatePairs();
+    } else {
+      switch (bp.mode) {
+        case BroadphaseMode::SpatialHash:
+          bp.findGridPairs(m_bpEntries, m_pairs);
+          break;
+        case BroadphaseMode::IncrementalSweep:
+          bp.findSweepPairs(m_bpEntries, m_pairs);
+          break;
+        default:
+          bp.findSortAndSweepPairs(m_bpEntries, m_pairs);
+          break;
+      }
+      bp.findStaticPairs(m_dynamicEntries, m_pairs);
+      bp.syncPairs(m_pairs);
+    }
+
+    const PairCache& pairs = bp.pairs();
+    wakeSeparated(reg, cm, pairs.removed());
+    cm.removePairs(pairs.removed());
 
     m_bodyIndex.clear();
     m_bodyIndex.reserve(m_bodies.size());
     for (size_t i = 0; i < m_bodies.size(); ++i)
-      m_bodyIndex[static_cast<uint32_t>(m_bodies[i].ent)] = i;
+      m_bodyIndex[static_cast<uint32_t>(m_bodies[i].frame.entity)] = i;
 
-    m_newContacts.clear();
-    m_newContacts.reserve(m_pairs.size());
-    m_collisionEvents.clear();
+    m_circleCircle.clear();
+    m_circlePoly.clear();
+    m_boxBox.clear();
+    m_polyPoly.clear();
+    m_reuse.clear();
+    m_asleep.clear();
+    m_waking.clear();
+
+    for (uint32_t slot : pairs.live()) {
+      const auto& pair = pairs[slot];
+      if (!bp.touching(pair)) continue;
 
-    for (auto& [entA, entB] : m_pairs) {
-      auto itA = m_bodyIndex.find(static_cast<uint32_t>(entA));
-      auto itB = m_bodyIndex.find(static_cast<uint32_t>(entB));
-      if (itA == m_bodyIndex.end() || itB == m_bodyIndex.end()) continue;
+      size_t ia = collidableIndex(reg, pair.a);
+      size_t ib = collidableIndex(reg, pair.b);
+      if (ia == kNoCollidable || ib == kNoCollidable) continue;
 
-      auto& A = m_bodies[itA->second];
-      auto& B = m_bodies[itB->second];
+      auto& A = m_bodies[ia];
+      auto& B = m_bodies[ib];
 
       if (!isDynamic(*A.rb) && !isDynamic(*B.rb)) continue;
 
       if (!shouldCollide(A.rb->filter, B.rb->filter)) continue;
 
-      bool aCircle = A.circle != nullptr;
-      bool bCircle = B.circle != nullptr;
-      bool aPoly   = A.box || A.convex;
-      bool bPoly   = B.box || B.convex;
-
-      std::optional<ContactConstraint> contact;
-
-      if (aCircle && bCircle) {
-        contact = narrowphase::circleVsCircle(
-          A.ent, *A.xf, *A.circle, B.ent, *B.xf, *B.circle);
-      } else if (aCircle && bPoly) {
-        contact = narrowphase::circleVsPoly(
-          A.ent, *A.xf, *A.circle, B.ent, *B.xf, B.box, B.convex, false);
-      } else if (aPoly && bCircle) {
-        contact = narrowphase::circleVsPoly(
-          B.ent, *B.xf, *B.circle, A.ent, *A.xf, A.box, A.convex, true);
-      } else if (aPoly && bPoly) {
-        contact = narrowphase::polyVsPoly(
-          A.ent, *A.xf, A.box, A.convex,
-          B.ent, *B.xf, B.box, B.convex);
+      // Pairs with nothing moving keep last step's contact as it was. A
+      // moving body reaching a sleeping one collides as usual and wakes it
+      // once they have a contact.
+      const bool activeA = isActive(*A.rb), activeB = isActive(*B.rb);
+      if (!activeA && !activeB) {
+        if (cm.find(slot))
+          m_asleep.push_back({ slot, static_cast<uint32_t>(ia),
+                               static_cast<uint32_t>(ib) });
+        continue;
+      }
+      if (isAsleep(*A.rb) || isAsleep(*B.rb))
+        m_waking.push_back({ slot, static_cast<uint32_t>(ia),
+                             static_cast<uint32_t>(ib) });
+
+      const float margin = speculativeContacts
+        ? bp.contactMargin + A.speculative + B.speculative : 0.f;
+      NarrowPair np{ slot, static_cast<uint32_t>(ia), static_cast<uint32_t>(ib),
+                     false, margin };
+      const ShapeKind ka = A.kind(), kb = B.kind();
+      if (ka == ShapeKind::Circle && kb == ShapeKind::Circle) {
+        m_circleCircle.push_back(np);
+        continue;
       }
 
-      if (contact) {
-        contact->friction    = std::sqrt(A.rb->friction * B.rb->friction);
-        contact->restitution = std::max(A.rb->restitution, B.rb->restitution);
-        m_newContacts.push_back(std::move(*contact));
-
-        auto& cc = m_newContacts.back();
-        CollisionEvent ev;
-        ev.entityA      = cc.bodyA;
-        ev.entityB      = cc.bodyB;
-        ev.normal       = cc.normal;
-        ev.penetration  = cc.points[0].penetration;
-        ev.contactPoint = cc.points[0].position;
-        m_collisionEvents.push_back(ev);
+      if (kb == ShapeKind::Circle)
+        np = { slot, np.b, np.a, true, margin };
+
+      if (manifoldReuse) {
+        const ContactConstraint* prev = cm.find(slot);
+        if (prev && canReuse(*prev, A, B)) {
+          m_reuse.push_back(np);
+          continue;
+        }
+      }
+
+      if (ka == ShapeKind::Circle || kb == ShapeKind::Circle) {
+        m_circlePoly.push_back(np);
+      } else if (ka == ShapeKind::Box && kb == ShapeKind::Box) {
+        m_boxBox.push_back(np);
+      } else {
+        m_polyPoly.push_back(np);
       }
     }
 
+    auto& pool = reg.ctx().get<ThreadPool>();
+    buildWorldPolys(pool);
+    m_previous = &cm;
+    runNarrowphase(pool);
+
     cm.update(m_newContacts);
+    if (!m_waking.empty()) wakeTouched(cm);
 
     if (reg.ctx().contains<CollisionPairTracker>()) {
       auto& tracker = reg.ctx().get<CollisionPairTracker>();
       auto& events  = reg.ctx().get<CollisionEvents>();
-      tracker.update(m_collisionEvents, events);
+      tracker.update(m_collisionEvents, pairs.removed(), events);
     }
   }
 
   const char* name() const override { return "CollisionDetection"; }
 
 private:
+  // Static proxies stay out of the per-step loop; this pass only checks
+  // that each one is still static and has not been moved since insertion.
+  void dropStaleStaticProxies(entt::registry& reg) {
+    m_staleStatics.clear();
+    auto view = reg.view<StaticBroadphaseProxy, RigidBody2D, TransformComponent>();
+    for (auto [e, sp, rb, xf] : view.each()) {
+      if (!isStatic(rb) || !sp.matches(xf))
+        m_staleStatics.push_back(e);
+    }
+    for (auto e : m_staleStatics)
+      reg.remove<StaticBroadphaseProxy>(e);
+  }
+
+  static constexpr size_t kNoCollidable = static_cast<size_t>(-1);
+
+  // Awake dynamic bodies, and kinematic ones that are moving.
+  static bool isActive(const RigidBody2D& rb) {
+    if (isDynamic(rb)) return !isAsleep(rb);
+    return isKinematic(rb) &&
+           (rb.velocity != glm::vec2(0.f) || rb.angularVelocity != 0.f);
+  }
+
+  // A body that lost a contact, because the other body or its collider
+  // went away, may have lost its support.
+  static void wakeSeparated(entt::registry& reg, const ContactManager& cm,
+                            const std::vector<uint32_t>& removed) {
+    for (uint32_t slot : removed) {
+      const ContactConstraint* cc = cm.find(slot);
+      if (!cc) continue;
+      for (entt::entity e : { cc->bodyA, cc->bodyB }) {
+        if (!reg.valid(e)) continue;
+        if (auto* rb = reg.try_get<RigidBody2D>(e); rb && isAsleep(*rb))
+          wakeBody(*rb);
+      }
+    }
+  }
+
+  // Sleeping bodies that now have a contact with a moving one wake, along
+  // with everything joined to them through the contacts their islands
+  // kept. Statics and kinematic bodies do not join islands.
+  void wakeTouched(const ContactManager& cm) {
+    const uint32_t n = static_cast<uint32_t>(m_bodies.size());
+    m_islands.reset(n);
+    m_wakeRoot.assign(n, 0);
+
+    for (const NarrowPair& np : m_asleep) {
+      if (isDynamic(*m_bodies[np.a].rb) && isDynamic(*m_bodies[np.b].rb))
+        m_islands.unite(np.a, np.b);
+    }
+
+    bool any = false;
+    for (const NarrowPair& np : m_waking) {
+      if (!cm.find(np.slot)) continue;
+      for (uint32_t i : { np.a, np.b }) {
+        if (!isAsleep(*m_bodies[i].rb)) continue;
+        m_wakeRoot[m_islands.find(i)] = 1;
+        any = true;
+      }
+    }
+    if (!any) return;
+
+    for (uint32_t i = 0; i < n; ++i) {
+      RigidBody2D& rb = *m_bodies[i].rb;
+      if (isAsleep(rb) && m_wakeRoot[m_islands.find(i)]) wakeBody(rb);
+    }
+  }
+
+  // How far any point of the body could move this step at its current
+  // velocity, with the AABB corners bounding its reach from the origin.
+  float speculativeDistance(const TransformComponent& xf, const RigidBody2D& rb,
+                            const AABB& aabb, float dt) const {
+    const glm::vec2 reach = glm::max(aabb.max - xf.position,
+                                     xf.position - aabb.min);
+    const float d = dt * (glm::length(rb.velocity) +
+                          std::abs(rb.angularVelocity) * glm::length(reach));
+    return std::min(d, maxSpeculativeDistance);
+  }
+
+  // Movers were gathered by the proxy pass; statics are only pulled in
+  // once a pair actually touches them.
+  size_t collidableIndex(entt::registry& reg, entt::entity e) {
+    auto it = m_bodyIndex.find(static_cast<uint32_t>(e));
+    if (it != m_bodyIndex.end()) return it->second;
+    if (!reg.all_of<StaticBroadphaseProxy>(e)) return kNoCollidable;
+
+    auto& xf = reg.get<TransformComponent>(e);
+    float c, s;
+    if (auto* world = reg.try_get<WorldAABB>(e); world && world->matches(xf)) {
+      c = world->cosR;
+      s = world->sinR;
+    } else {
+      c = std::cos(xf.rotation);
+      s = std::sin(xf.rotation);
+    }
+
+    size_t index = m_bodies.size();
+    m_bodyIndex.emplace(static_cast<uint32_t>(e), index);
+    m_bodies.push_back({ { e, &xf, c, s }, &reg.get<RigidBody2D>(e),
+      reg.try_get<CircleCollider>(e), reg.try_get<BoxCollider>(e),
+      reg.try_get<ConvexCollider>(e) });
+    return index;
+  }
+
+  static constexpr uint32_t kNoPoly = static_cast<uint32_t>(-1);
+
+  // Pairs per narrowphase task; a multiple of the four SIMD lanes.
+  static constexpr uint32_t kTaskPairs = 256;
+  static constexpr uint32_t kTaskPolys = 256;
+
+  enum class ShapeKind : uint8_t { Circle, Box, Poly };
+
   struct Collidable {
-    entt::entity      ent;
-    TransformComponent* xf;
+    narrowphase::BodyFrame frame;
     RigidBody2D*       rb;
     CircleCollider*    circle  = nullptr;
     BoxCollider*       box     = nullptr;
     ConvexCollider*    convex  = nullptr;
+    uint32_t           poly    = kNoPoly;
+    float              speculative = 0.f;   // reach this step, 0 for statics
+
+    // Mirrored or degenerate boxes go through the polygon routines.
+    ShapeKind kind() const {
+      if (circle) return ShapeKind::Circle;
+      if (box) {
+        glm::vec2 half = box->halfExtents * frame.xf->scale;
+        if (half.x > 0.f && half.y > 0.f) return ShapeKind::Box;
+      }
+      return ShapeKind::Poly;
+    }
+  };
+
+  // Bodies are indices into m_bodies. Circle-poly pairs keep the circle in
+  // a; flipped means the polygon was body A of the broadphase pair. Contacts
+  // are kept for points up to margin apart.
+  struct NarrowPair {
+    uint32_t slot;
+    uint32_t a, b;
+    bool     flipped = false;
+    float    margin  = 0.f;
   };
 
+  struct NarrowOutput {
+    std::vector<ContactConstraint> contacts;
+    std::vector<CollisionEvent>    events;
+  };
+
+  using Kernel = void (CollisionDetectionSystem::*)(const NarrowPair*, size_t,
+                                                    NarrowOutput&) const;
+
+  // A contiguous run of one bucket. Each task owns its output buffers.
+  struct NarrowTask {
+    Kernel            kernel;
+    const NarrowPair* pairs;
+    uint32_t          count;
+  };
+
+  bool canReuse(const ContactConstraint& prev, const Collidable& A,
+                const Collidable& B) const {
+    const bool swap = prev.bodyA != A.frame.entity;
+    return narrowphase::poseWithin(prev.pose, swap ? B.frame : A.frame,
+                                   swap ? A.frame : B.frame,
+                                   reuseLinearTolerance, reuseAngularTolerance);
+  }
+
+  void requestPoly(Collidable& b) {
+    if (b.poly != kNoPoly) return;
+    b.poly = static_cast<uint32_t>(m_polyOwners.size());
+    m_polyOwners.push_back(static_cast<uint32_t>(&b - m_bodies.data()));
+  }
+
+  // Indices are handed out serially so the kernels only ever read m_polys;
+  // the polygons themselves are built in parallel.
+  void buildWorldPolys(ThreadPool& pool) {
+    m_polyOwners.clear();
+    for (const NarrowPair& np : m_circlePoly)
+      requestPoly(m_bodies[np.b]);
+    for (const NarrowPair& np : m_polyPoly) {
+      requestPoly(m_bodies[np.a]);
+      requestPoly(m_bodies[np.b]);
+    }
+
+    const uint32_t count = static_cast<uint32_t>(m_polyOwners.size());
+    if (m_polys.size() < count) m_polys.resize(count);
+    pool.parallelFor((count + kTaskPolys - 1) / kTaskPolys, [&](uint32_t t) {
+      const uint32_t end = std::min(count, (t + 1) * kTaskPolys);
+      for (uint32_t i = t * kTaskPolys; i < end; ++i) {
+        const Collidable& b = m_bodies[m_polyOwners[i]];
+        narrowphase::makeWorldPoly(m_polys[i], *b.frame.xf, b.frame.c,
+                                   b.frame.s, b.box, b.convex);
+      }
+    });
+  }
+
+  void addTasks(Kernel kernel, const std::vector<NarrowPair>& bucket) {
+    const uint32_t n = static_cast<uint32_t>(bucket.size());
+    for (uint32_t begin = 0; begin < n; begin += kTaskPairs)
+      m_tasks.push_back({ kernel, bucket.data() + begin,
+                          std::min(kTaskPairs, n - begin) });
+  }
+
+  // Tasks are appended back in creation order, so contacts and events come
+  // out in the same order however many threads ran them.
+  void runNarrowphase(ThreadPool& pool) {
+    m_tasks.clear();
+    addTasks(&CollisionDetectionSystem::runCircleCircle, m_circleCircle);
+    addTasks(&CollisionDetectionSystem::runCirclePoly,   m_circlePoly);
+    addTasks(&CollisionDetectionSystem::runBoxBox,       m_boxBox);
+    addTasks(&CollisionDetectionSystem::runPolyPoly,     m_polyPoly);
+    addTasks(&CollisionDetectionSystem::runReuse,        m_reuse);
+    addTasks(&CollisionDetectionSystem::runAsleep,       m_asleep);
+
+    const uint32_t taskCount = static_cast<uint32_t>(m_tasks.size());
+    if (m_taskOutputs.size() < taskCount) m_taskOutputs.resize(taskCount);
+
+    pool.parallelFor(taskCount, [&](uint32_t t) {
+      const NarrowTask& task = m_tasks[t];
+      NarrowOutput&     out  = m_taskOutputs[t];
+      out.contacts.clear();
+      out.events.clear();
+      (this->*task.kernel)(task.pairs, task.count, out);
+    });
+
+    size_t contactCount = 0;
+    for (uint32_t t = 0; t < taskCount; ++t)
+      contactCount += m_taskOutputs[t].contacts.size();
+
+    m_newContacts.clear();
+    m_newContacts.reserve(contactCount);
+    m_collisionEvents.clear();
+    m_collisionEvents.reserve(contactCount);
+    for (uint32_t t = 0; t < taskCount; ++t) {
+      const NarrowOutput& out = m_taskOutputs[t];
+      m_newContacts.insert(m_newContacts.end(), out.contacts.begin(), out.contacts.end());
+      m_collisionEvents.insert(m_collisionEvents.end(), out.events.begin(), out.events.end());
+    }
+  }
+
+  // Runs test into a fresh contact and keeps it, with its event, if test
+  // reports a hit.
+  template<typename Test>
+  void emit(NarrowOutput& out, const NarrowPair& np, Test&& test) const {
+    ContactConstraint& cc = out.contacts.emplace_back();
+    if (!test(cc)) {
+      out.contacts.pop_back();
+      return;
+    }
+    const Collidable& A = m_bodies[np.a];
+    const Collidable& B = m_bodies[np.b];
+    cc.pairId      = np.slot;
+    cc.friction    = std::sqrt(A.rb->friction * B.rb->friction);
+    cc.restitution = std::max(A.rb->restitution, B.rb->restitution);
+    cc.pose        = cc.bodyA == A.frame.entity
+                   ? narrowphase::manifoldPose(A.frame, B.frame, cc.normal)
+                   : narrowphase::manifoldPose(B.frame, A.frame, cc.normal);
+    pushEvent(out, cc, np.slot);
+  }
+
+  // Speculative contacts resting bodies settle onto sit right at zero
+  // separation; this much of a gap still counts as touching for events.
+  static constexpr float kTouchTolerance = 0.005f;
+
+  // Only touching contacts are reported; the rest stay between the
+  // narrowphase and the solver.
+  void pushEvent(NarrowOutput& out, const ContactConstraint& cc,
+                 uint32_t slot) const {
+    int deepest = 0;
+    for (int i = 1; i < cc.pointCount; ++i)
+      if (cc.points[i].penetration > cc.points[deepest].penetration) deepest = i;
+    if (cc.points[deepest].penetration < -kTouchTolerance) return;
+
+    CollisionEvent ev;
+    ev.entityA      = cc.bodyA;
+    ev.entityB      = cc.bodyB;
+    ev.normal       = cc.normal;
+    ev.penetration  = cc.points[deepest].penetration;
+    ev.contactPoint = cc.points[deepest].position;
+    ev.pairId       = slot;
+    out.events.push_back(ev);
+  }
+
+  // Four pairs per pass through the SIMD overlap test; only lanes within
+  // their margin build a contact.
+  void runCircleCircle(const NarrowPair* pairs, size_t n,
+                       NarrowOutput& out) const {
+    for (size_t base = 0; base < n; base += 4) {
+      const size_t lanes = std::min<size_t>(4, n - base);
+      float ax[4] = {}, ay[4] = {}, bx[4] = {}, by[4] = {}, rSum[4] = {};
+      glm::vec2 posA[4], posB[4];
+      float     rA[4], rB[4];
+
+      for (size_t k = 0; k < lanes; ++k) {
+        const NarrowPair& np = pairs[base + k];
+        const Collidable& A  = m_bodies[np.a];
+        const Collidable& B  = m_bodies[np.b];
+        posA[k] = A.frame.toWorld(A.circle->offset);
+        posB[k] = B.frame.toWorld(B.circle->offset);
+        rA[k]   = narrowphase::circleRadius(*A.frame.xf, *A.circle);
+        rB[k]   = narrowphase::circleRadius(*B.frame.xf, *B.circle);
+        ax[k] = posA[k].x;  ay[k] = posA[k].y;
+        bx[k] = posB[k].x;  by[k] = posB[k].y;
+        rSum[k] = rA[k] + rB[k] + np.margin;
+      }
+
+      const int hits = narrowphase::circlesOverlap4(ax, ay, bx, by, rSum);
+      for (size_t k = 0; k < lanes; ++k) {
+        if (!(hits & (1 << k))) continue;
+        const NarrowPair& np = pairs[base + k];
+        emit(out, np, [&](ContactConstraint& cc) {
+          return narrowphase::circleContact(
+            m_bodies[np.a].frame, posA[k], rA[k],
+            m_bodies[np.b].frame, posB[k], rB[k], cc, np.margin);
+        });
+      }
+    }
+  }
+
+  void runCirclePoly(const NarrowPair* pairs, size_t n,
+                     NarrowOutput& out) const {
+    for (size_t i = 0; i < n; ++i) {
+      const NarrowPair& np = pairs[i];
+      const Collidable& C  = m_bodies[np.a];
+      const Collidable& P  = m_bodies[np.b];
+      emit(out, np, [&](ContactConstraint& cc) {
+        return narrowphase::circleVsPoly(C.frame, *C.circle, P.frame,
+                                         m_polys[P.poly], np.flipped, cc,
+                                         np.margin);
+      });
+    }
+  }
+
+  // Only boxes with positive extents land here (see Collidable::kind), so
+  // WorldBox always applies.
+  void runBoxBox(const NarrowPair* pairs, size_t n, NarrowOutput& out) const {
+    for (size_t base = 0; base < n; base += 4) {
+      const size_t lanes = std::min<size_t>(4, n - base);
+      narrowphase::BoxLanes la{}, lb{};
+      narrowphase::WorldBox wa[4], wb[4];
+      float margin[4] = {};
+      for (size_t k = 0; k < lanes; ++k) {
+        const NarrowPair& np = pairs[base + k];
+        const Collidable& A  = m_bodies[np.a];
+        const Collidable& B  = m_bodies[np.b];
+        narrowphase::makeWorldBox(wa[k], A.frame, *A.box);
+        narrowphase::makeWorldBox(wb[k], B.frame, *B.box);
+        la.set(static_cast<int>(k), wa[k].center, A.frame.c, A.frame.s, wa[k].half);
+        lb.set(static_cast<int>(k), wb[k].center, B.frame.c, B.frame.s, wb[k].half);
+        margin[k] = np.margin;
+      }
+
+      const int hits = narrowphase::boxesOverlap4(la, lb, margin) &
+                       ((1 << lanes) - 1);
+      for (size_t k = 0; k < lanes; ++k) {
+        if (!(hits & (1 << k))) continue;
+        const NarrowPair& np = pairs[base + k];
+        emit(out, np, [&](ContactConstraint& cc) {
+          return narrowphase::boxVsBox(m_bodies[np.a].frame, wa[k],
+                                       m_bodies[np.b].frame, wb[k], cc,
+                                       np.margin);
+        });
+      }
+    }
+  }
+
+  void runPolyPoly(const NarrowPair* pairs, size_t n, NarrowOutput& out) const {
+    for (size_t i = 0; i < n; ++i) {
+      const NarrowPair& np = pairs[i];
+      const Collidable& A  = m_bodies[np.a];
+      const Collidable& B  = m_bodies[np.b];
+      emit(out, np, [&](ContactConstraint& cc) {
+        return narrowphase::polyVsPoly(A.frame, m_polys[A.poly],
+                                       B.frame, m_polys[B.poly], cc,
+                                       np.margin);
+      });
+    }
+  }
+
+  // Pairs picked by canReuse. The pose is left as it was when the manifold
+  // was built, so drift is measured from there and not from the last
+  // refresh. Manifolds that stop holding fall back to a full collide.
+  void runReuse(const NarrowPair* pairs, size_t n, NarrowOutput& out) const {
+    narrowphase::WorldPoly polyA, polyB;
+    for (size_t i = 0; i < n; ++i) {
+      const NarrowPair& np = pairs[i];
+      const Collidable& A  = m_bodies[np.a];
+      const Collidable& B  = m_bodies[np.b];
+      ContactConstraint& cc =
+        out.contacts.emplace_back(*m_previous->find(np.slot));
+      const bool swap = cc.bodyA != A.frame.entity;
+      if (narrowphase::refreshManifold(swap ? B.frame : A.frame,
+                                       swap ? A.frame : B.frame, cc,
+                                       np.margin)) {
+        pushEvent(out, cc, np.slot);
+        continue;
+      }
+      out.contacts.pop_back();
+      emit(out, np, [&](ContactConstraint& fresh) {
+        return collide(np, polyA, polyB, fresh);
+      });
+    }
+  }
+
+  void runAsleep(const NarrowPair* pairs, size_t n, NarrowOutput& out) const {
+    for (size_t i = 0; i < n; ++i) {
+      const ContactConstraint& cc =
+        out.contacts.emplace_back(*m_previous->find(pairs[i].slot));
+      pushEvent(out, cc, pairs[i].slot);
+    }
+  }
+
+  // One pair outside the buckets; world polygons go into the scratch ones
+  // passed in, since the pair never asked for a slot in m_polys.
+  bool collide(const NarrowPair& np, narrowphase::WorldPoly& polyA,
+               narrowphase::WorldPoly& polyB, ContactConstraint& cc) const {
+    const Collidable& A = m_bodies[np.a];
+    const Collidable& B = m_bodies[np.b];
+    if (A.circle) {
+      narrowphase::makeWorldPoly(polyB, *B.frame.xf, B.frame.c, B.frame.s,
+                                 B.box, B.convex);
+      return narrowphase::circleVsPoly(A.frame, *A.circle, B.frame, polyB,
+                                       np.flipped, cc, np.margin);
+    }
+    if (A.kind() == ShapeKind::Box && B.kind() == ShapeKind::Box) {
+      narrowphase::WorldBox wa, wb;
+      narrowphase::makeWorldBox(wa, A.frame, *A.box);
+      narrowphase::makeWorldBox(wb, B.frame, *B.box);
+      return narrowphase::boxVsBox(A.frame, wa, B.frame, wb, cc, np.margin);
+    }
+    narrowphase::makeWorldPoly(polyA, *A.frame.xf, A.frame.c, A.frame.s,
+                               A.box, A.convex);
+    narrowphase::makeWorldPoly(polyB, *B.frame.xf, B.frame.c, B.frame.s,
+                               B.box, B.convex);
+    return narrowphase::polyVsPoly(A.frame, polyA, B.frame, polyB, cc,
+                                   np.margin);
+  }
+
   std::vector<Collidable>                  m_bodies;
+  std::vector<narrowphase::WorldPoly>      m_polys;
+  std::vector<uint32_t>                    m_polyOwners;
+  std::vector<NarrowPair>                  m_circleCircle;
+  std::vector<NarrowPair>                  m_circlePoly;
+  std::vector<NarrowPair>                  m_boxBox;
+  std::vector<NarrowPair>                  m_polyPoly;
+  std::vector<NarrowPair>                  m_reuse;
+  std::vector<NarrowPair>                  m_asleep;
+  std::vector<NarrowPair>                  m_waking;
+  UnionFind                                m_islands;
+  std::vector<uint8_t>                     m_wakeRoot;
+  const ContactManager*                    m_previous = nullptr;
+  std::vector<NarrowTask>                  m_tasks;
+  std::vector<NarrowOutput>                m_taskOutputs;
   std::vector<BroadphaseEntry>             m_bpEntries;
   std::vector<BroadphasePair>              m_pairs;
+  std::vector<BroadphaseEntry>             m_dynamicEntries;
+  std::vector<BroadphaseEntry>             m_newStatics;
+  std::vector<entt::entity>                m_staleStatics;
   std::unordered_map<uint32_t, size_t>     m_bodyIndex;
   std::vector<ContactConstraint>           m_newContacts;
   std::vector<CollisionEvent>              m_collisionEvents;
@@ -1,11 +1,15 @@
 #pragma once
 #include "../physicsSystem.hpp"
 #include "../contact.hpp"
+#include "../threadPool.hpp"
+#include "../simd.hpp"
+#include "../entityIndex.hpp"
 #include "components/transform.hpp"
 #include "components/physics_components.hpp"
 #include <glm/glm.hpp>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <vector>
 
@@ -20,6 +24,25 @@ public:
   float maxPositionCorrection = 0.2f; 
   float restitutionThreshold  = 1.0f; 
 
+  // Contacts are split into colors in which no two share a dynamic body,
+  // and colors are solved one after another, each across the ThreadPool.
+  // The order only depends on the contacts, so the result does not change
+  // with the thread count. Contacts that find no free color go into an
+  // overflow set solved on the calling thread after the colors.
+  static constexpr int kColorCount = 16;
+
+  // Solves the contacts of each color four at a time with Float4 math.
+  // The overflow set always goes through the scalar path.
+  bool wideContacts = true;
+
+  // SoftStep solves soft contacts over substeps and ignores the iterations.
+  enum class Mode { Baumgarte, SoftStep };
+  Mode  mode                 = Mode::Baumgarte;
+  int   substeps             = 8;
+  float contactHertz         = 120.f; // stiff: sag does not shrink with the bodies
+  float contactDampingRatio  = 10.f;
+  float contactPushVelocity  = 3.f;   // m/s, overlap is pushed out no faster
+
   void addVelocityConstraint(VelocityConstraintFn fn) {
     m_velocityConstraints.push_back(std::move(fn));
   }
@@ -28,67 +51,207 @@ public:
     m_velocityConstraints.clear();
   }
 
+  // Bodies in contact are solved from the solver's own copy until the end
+  // of the step, so velocity constraints read and write them through this.
+  struct VelocityRef {
+    glm::vec2& linear;
+    float&     angular;
+  };
+
+  VelocityRef velocityOf(entt::registry& reg, entt::entity e) {
+    const uint32_t i = bodyIndex(e);
+    if (i != kNoBody) return { m_bodies[i].velocity, m_bodies[i].angularVelocity };
+    auto& rb = reg.get<RigidBody2D>(e);
+    return { rb.velocity, rb.angularVelocity };
+  }
+
   void fixedUpdate(entt::registry& reg, float dt) override {
     if (!reg.ctx().contains<ContactManager>()) return;
     auto& cm = reg.ctx().get<ContactManager>();
 
-    integrateVelocities(reg, dt);
+    beginBodies();
 
     if (cm.empty() && m_velocityConstraints.empty()) {
+      integrateVelocities(reg, dt);
       integratePositions(reg, dt);
       clearBodyForces(reg);
       return;
     }
 
-    m_solverContacts.clear();
-    m_solverContacts.reserve(cm.size());
+    // The soft step integrates the bodies in contact once per substep, so
+    // it copies them out before gravity.
+    if (mode == Mode::Baumgarte) integrateVelocities(reg, dt);
+
+    m_contacts.clear();
+    m_contacts.reserve(cm.size());
     for (auto& cc : cm) {
-      m_solverContacts.push_back({
+      auto& rbA = reg.get<RigidBody2D>(cc.bodyA);
+      auto& rbB = reg.get<RigidBody2D>(cc.bodyB);
+      if (!simulated(rbA) && !simulated(rbB)) continue;
+      m_contacts.push_back({
         &cc,
-        &reg.get<TransformComponent>(cc.bodyA),
-        &reg.get<RigidBody2D>(cc.bodyA),
-        &reg.get<TransformComponent>(cc.bodyB),
-        &reg.get<RigidBody2D>(cc.bodyB)
+        addBody(reg, cc.bodyA, rbA),
+        addBody(reg, cc.bodyB, rbB),
+        simulated(rbA),
+        simulated(rbB)
       });
     }
+    if (mode == Mode::SoftStep) integrateVelocities(reg, dt);
+    colorContacts();
 
-    for (auto& sc : m_solverContacts)
-      preStep(sc, dt);
+    if (wideContacts) packWide();
 
-    for (auto& sc : m_solverContacts)
-      warmStart(sc);
+    ThreadPool* pool = reg.ctx().find<ThreadPool>();
+
+    forEachContact(pool, [&](SolverContact& sc) { preStep(sc, dt); },
+                         [&](WideContact& wc)   { preStepWide(wc, dt); });
+
+    if (mode == Mode::SoftStep)
+      stepSoft(reg, pool, dt);
+    else
+      stepBaumgarte(reg, pool, dt);
+
+    storeBodies();
+    clearBodyForces(reg);
+  }
+
+  const char* name() const override { return "ConstraintSolver"; }
+
+private:
+  void stepBaumgarte(entt::registry& reg, ThreadPool* pool, float dt) {
+    forEachColor(pool, [&](SolverContact& sc) { warmStart(sc); },
+                       [&](WideContact& wc)   { warmStartWide(wc); });
 
     for (int i = 0; i < velocityIterations; ++i) {
       for (auto& fn : m_velocityConstraints)
         fn(reg);
 
-      for (auto& sc : m_solverContacts)
-        solveVelocity(sc);
+      forEachColor(pool, [&](SolverContact& sc) { solveVelocity(sc); },
+                         [&](WideContact& wc)   { solveVelocityWide(wc); });
     }
 
+    if (wideContacts) storeImpulses();
+
     integratePositions(reg, dt);
+    integrateBodies(dt);
+
+    for (int i = 0; i < positionIterations; ++i)
+      forEachColor(pool, [&](SolverContact& sc) { solvePosition(sc); },
+                         [&](WideContact& wc)   { solvePositionWide(wc); });
+  }
+
+  // Accumulated impulses are per substep, so the warm start applies them
+  // again at the start of every substep.
+  void stepSoft(entt::registry& reg, ThreadPool* pool, float dt) {
+    const int   count = std::max(substeps, 1);
+    const float h     = dt / count;
+    const float hertz = std::min(contactHertz, 0.25f / h);
+    m_invH        = 1.f / h;
+    m_contactSoft = makeSoft(hertz, contactDampingRatio, h);
+    m_staticSoft  = makeSoft(2.f * hertz, contactDampingRatio, h);
+
+    for (int i = 0; i < count; ++i) {
+      integrateBodyVelocities(h);
+      forEachColor(pool, [&](SolverContact& sc) { warmStart(sc); },
+                         [&](WideContact& wc)   { warmStartWide(wc); });
 
-    for (int i = 0; i < positionIterations; ++i) {
-      for (auto& sc : m_solverContacts)
-        solvePosition(sc);
+      for (auto& fn : m_velocityConstraints)
+        fn(reg);
+
+      forEachColor(pool, [&](SolverContact& sc) { solveSoft(sc, true); },
+                         [&](WideContact& wc)   { solveSoftWide(wc, true); });
+      integrateBodies(h);
+      forEachColor(pool, [&](SolverContact& sc) { solveSoft(sc, false); },
+                         [&](WideContact& wc)   { solveSoftWide(wc, false); });
     }
 
-    clearBodyForces(reg);
+    forEachColor(pool, [&](SolverContact& sc) { applyRestitution(sc); },
+                       [&](WideContact& wc)   { applyRestitutionWide(wc); });
+
+    if (wideContacts) storeImpulses();
+
+    integratePositions(reg, dt);
   }
 
-  const char* name() const override { return "ConstraintSolver"; }
+  static constexpr uint32_t kTaskContacts = 128;
+  static constexpr uint32_t kTaskBatches  = kTaskContacts / 4;
 
-private:
+  static constexpr uint32_t kNoBody = EntityIndex::kNone;
+
+  // The state the iterations touch, copied out of the ECS for every body in
+  // contact and stored back once at the end of the step. Entry 0 is a
+  // static body at the origin that fills empty batch lanes.
+  struct SolverBody {
+    glm::vec2 velocity{0.f};
+    float     angularVelocity = 0.f;
+    float     invMass         = 0.f;
+    float     invInertia      = 0.f;
+    glm::vec2 position{0.f};
+    float     rotation        = 0.f;
+    glm::vec2 deltaPosition{0.f};       // moved since the step began
+    glm::vec2 deltaRotation{1.f, 0.f};  // cos, sin of the turn since then
+  };
+
+  // Spring coefficients for one substep: the bias turns overlap into a
+  // velocity, and the scales soften the mass and bleed off some of the
+  // accumulated impulse.
+  struct Softness {
+    float biasRate     = 0.f;
+    float massScale    = 1.f;
+    float impulseScale = 0.f;
+  };
+
+  struct BodyLink {
+    TransformComponent* xf;
+    RigidBody2D*        rb;
+  };
+
+  // moveA/moveB say whether the solver may write the body. Statics and
+  // kinematic bodies are only read, so the many contacts on one floor can
+  // share a color.
   struct SolverContact {
-    ContactConstraint*  cc;
-    TransformComponent* xfA;
-    RigidBody2D*        rbA;
-    TransformComponent* xfB;
-    RigidBody2D*        rbB;
+    ContactConstraint* cc;
+    uint32_t           a, b;    // into m_bodies
+    bool               moveA;
+    bool               moveB;
+  };
+
+  // Up to four contacts of one color, one per lane. Empty lanes and
+  // missing second points have zero mass, so they never push anything;
+  // live masks them out of the position pass.
+  struct WidePoint {
+    Float4 rAx, rAy, rBx, rBy;
+    Float4 localAx, localAy, localBx, localBy;
+    Float4 normalMass, tangentMass, bias;
+    Float4 normalImpulse, tangentImpulse;
+    Float4 adjustedSeparation, relativeVelocity, maxNormalImpulse;
+    Float4 live;
   };
 
-  std::vector<SolverContact>      m_solverContacts;
+  struct WideContact {
+    ContactConstraint* cc[4];
+    uint32_t           a[4], b[4];
+    int                moveA;   // lane bits
+    int                moveB;
+    Float4 nx, ny, friction, restitution;
+    Float4 invMassA, invIA, invMassB, invIB;
+    WidePoint pt[2];
+  };
+
+  std::vector<SolverBody>         m_bodies;
+  std::vector<BodyLink>           m_links;
+  EntityIndex                     m_bodyLookup;
+  std::vector<SolverContact>      m_contacts;
+  std::vector<SolverContact>      m_solverContacts;   // in color order
+  uint32_t                        m_colorEnd[kColorCount + 1] = {};
+  std::vector<uint64_t>           m_colorBodies[kColorCount];
+  std::vector<uint8_t>            m_contactColor;
+  std::vector<WideContact>        m_wide;             // colors only
+  uint32_t                        m_wideEnd[kColorCount] = {};
   std::vector<VelocityConstraintFn> m_velocityConstraints;
+  float                           m_invH = 0.f;
+  Softness                        m_contactSoft;
+  Softness                        m_staticSoft;     // one side immovable
 
   static float cross2(const glm::vec2& a, const glm::vec2& b) {
     return a.x * b.y - a.y * b.x;
@@ -97,35 +260,203 @@ private:
     return { -s * v.y, s * v.x };
   }
 
+  // Contacts between sleeping islands and the static world are kept for
+  // when the island wakes, but there is nothing to solve in them.
+  static bool simulated(const RigidBody2D& rb) {
+    return isDynamic(rb) && !isAsleep(rb);
+  }
+
+  // First fit: each contact takes the lowest color that neither of its
+  // moving bodies is in yet.
+  void colorContacts() {
+    const uint32_t n = static_cast<uint32_t>(m_contacts.size());
+    for (auto& bits : m_colorBodies) bits.assign(m_bodies.size() / 64 + 1, 0);
+
+    uint32_t counts[kColorCount + 1] = {};
+    m_contactColor.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+      const SolverContact& sc = m_contacts[i];
+      const uint32_t a = sc.a, b = sc.b;
+      int color = 0;
+      for (; color < kColorCount; ++color) {
+        auto& bits = m_colorBodies[color];
+        if (sc.moveA && (bits[a >> 6] >> (a & 63) & 1)) continue;
+        if (sc.moveB && (bits[b >> 6] >> (b & 63) & 1)) continue;
+        if (sc.moveA) bits[a >> 6] |= uint64_t(1) << (a & 63);
+        if (sc.moveB) bits[b >> 6] |= uint64_t(1) << (b & 63);
+        break;
+      }
+      m_contactColor[i] = static_cast<uint8_t>(color);
+      ++counts[color];
+    }
+
+    uint32_t offset[kColorCount + 1];
+    uint32_t sum = 0;
+    for (int c = 0; c <= kColorCount; ++c) {
+      offset[c] = sum;
+      sum += counts[c];
+      m_colorEnd[c] = sum;
+    }
+    m_solverContacts.resize(n);
+    for (uint32_t i = 0; i < n; ++i)
+      m_solverContacts[offset[m_contactColor[i]]++] = m_contacts[i];
+  }
+
+  // preStep only writes its own contact, so it runs over every contact at
+  // once; the other passes go color by color.
+  template<typename Fn, typename WideFn>
+  void forEachContact(ThreadPool* pool, Fn&& fn, WideFn&& wideFn) {
+    const uint32_t overflow = m_colorEnd[kColorCount - 1];
+    if (wideContacts)
+      runTasks(pool, m_wide, 0, static_cast<uint32_t>(m_wide.size()),
+               kTaskBatches, wideFn);
+    runTasks(pool, m_solverContacts, wideContacts ? overflow : 0,
+             m_colorEnd[kColorCount], kTaskContacts, fn);
+  }
+
+  template<typename Fn, typename WideFn>
+  void forEachColor(ThreadPool* pool, Fn&& fn, WideFn&& wideFn) {
+    uint32_t begin = 0, wideBegin = 0;
+    for (int c = 0; c < kColorCount; ++c) {
+      if (wideContacts)
+        runTasks(pool, m_wide, wideBegin, m_wideEnd[c], kTaskBatches, wideFn);
+      else
+        runTasks(pool, m_solverContacts, begin, m_colorEnd[c], kTaskContacts, fn);
+      begin     = m_colorEnd[c];
+      wideBegin = m_wideEnd[c];
+    }
+    for (uint32_t i = begin; i < m_colorEnd[kColorCount]; ++i)
+      fn(m_solverContacts[i]);
+  }
+
+  template<typename T, typename Fn>
+  static void runTasks(ThreadPool* pool, std::vector<T>& items, uint32_t begin,
+                       uint32_t end, uint32_t perTask, Fn& fn) {
+    const uint32_t tasks = (end - begin + perTask - 1) / perTask;
+    if (!pool || tasks < 2) {
+      for (uint32_t i = begin; i < end; ++i) fn(items[i]);
+      return;
+    }
+    pool->parallelFor(tasks, [&](uint32_t t) {
+      const uint32_t first = begin + t * perTask;
+      const uint32_t last  = std::min(end, first + perTask);
+      for (uint32_t i = first; i < last; ++i) fn(items[i]);
+    });
+  }
+
+  void beginBodies() {
+    m_bodyLookup.clear();
+    m_bodies.assign(1, SolverBody{});
+    m_links.assign(1, BodyLink{ nullptr, nullptr });
+  }
+
+  uint32_t addBody(entt::registry& reg, entt::entity e, RigidBody2D& rb) {
+    const uint32_t next  = static_cast<uint32_t>(m_bodies.size());
+    const uint32_t index = m_bodyLookup.insert(e, next);
+    if (index != next) return index;
+
+    auto& xf = reg.get<TransformComponent>(e);
+    m_bodies.push_back({ rb.velocity, rb.angularVelocity, rb.invMass,
+                         rb.invInertia, xf.position, xf.rotation });
+    m_links.push_back({ &xf, &rb });
+    return index;
+  }
+
+  uint32_t bodyIndex(entt::entity e) const {
+    return m_bodyLookup.find(e);
+  }
+
+  // The deltas keep the turn as a normalized cos/sin pair, so the soft
+  // step can rotate anchors without trig.
+  void integrateBodies(float dt) {
+    for (uint32_t i = 1; i < m_bodies.size(); ++i) {
+      const RigidBody2D& rb = *m_links[i].rb;
+      if (isStatic(rb) || isAsleep(rb)) continue;
+      SolverBody& b = m_bodies[i];
+      const float turn = b.angularVelocity * dt;
+      b.position += b.velocity * dt;
+      b.rotation  = wrapAngle(b.rotation + turn);
+      b.deltaPosition += b.velocity * dt;
+      b.deltaRotation  = glm::normalize(b.deltaRotation + cross2(turn, b.deltaRotation));
+    }
+  }
+
+  void integrateBodyVelocities(float dt) {
+    for (uint32_t i = 1; i < m_bodies.size(); ++i) {
+      const RigidBody2D& rb = *m_links[i].rb;
+      if (!simulated(rb)) continue;
+      integrateVelocity(rb, m_bodies[i].velocity, m_bodies[i].angularVelocity, dt);
+    }
+  }
+
+  // Velocities only change for simulated bodies, poses for anything the
+  // step moves; kinematic bodies are moved but never pushed.
+  void storeBodies() {
+    for (uint32_t i = 1; i < m_bodies.size(); ++i) {
+      const SolverBody& b = m_bodies[i];
+      RigidBody2D& rb = *m_links[i].rb;
+      if (isStatic(rb) || isAsleep(rb)) continue;
+      if (isDynamic(rb)) {
+        rb.velocity        = b.velocity;
+        rb.angularVelocity = b.angularVelocity;
+      }
+      m_links[i].xf->position = b.position;
+      m_links[i].xf->rotation = b.rotation;
+    }
+  }
+
+  static float wrapAngle(float a) {
+    constexpr float TWO_PI = 2.0f * 3.14159265f;
+    if (a > 3.14159265f)       a -= TWO_PI;
+    else if (a < -3.14159265f) a += TWO_PI;
+    return a;
+  }
+
+  // Bodies in the solver array are integrated there instead.
   void integrateVelocities(entt::registry& reg, float dt) {
     auto view = reg.view<RigidBody2D>();
     for (auto [entity, rb] : view.each()) {
-      if (!isDynamic(rb)) continue;
+      if (!simulated(rb)) continue;
+      if (bodyIndex(entity) != kNoBody) continue;
+      integrateVelocity(rb, rb.velocity, rb.angularVelocity, dt);
+    }
+  }
 
-      rb.velocity += (rb.force * rb.invMass) * dt;
+  static void integrateVelocity(const RigidBody2D& rb, glm::vec2& velocity,
+                                float& angularVelocity, float dt) {
+    velocity += (rb.force * rb.invMass) * dt;
 
-      rb.angularVelocity += (rb.torque * rb.invInertia) * dt;
+    angularVelocity += (rb.torque * rb.invInertia) * dt;
 
-      rb.velocity        *= 1.f / (1.f + rb.linearDamping  * dt);
-      rb.angularVelocity *= 1.f / (1.f + rb.angularDamping * dt);
+    velocity        *= 1.f / (1.f + rb.linearDamping  * dt);
+    angularVelocity *= 1.f / (1.f + rb.angularDamping * dt);
 
-      float speed2 = glm::dot(rb.velocity, rb.velocity);
-      if (speed2 > rb.maxLinearSpeed * rb.maxLinearSpeed)
-        rb.velocity *= rb.maxLinearSpeed / std::sqrt(speed2);
-    }
+    float speed2 = glm::dot(velocity, velocity);
+    if (speed2 > rb.maxLinearSpeed * rb.maxLinearSpeed)
+      velocity *= rb.maxLinearSpeed / std::sqrt(speed2);
   }
 
+  static Softness makeSoft(float hertz, float dampingRatio, float h) {
+    if (hertz <= 0.f) return {};
+    const float omega = 2.f * 3.14159265f * hertz;
+    const float a1 = 2.f * dampingRatio + h * omega;
+    const float a2 = h * omega * a1;
+    const float a3 = 1.f / (1.f + a2);
+    return { omega / a1, a2 * a3, a3 };
+  }
+
+  // Bodies in the solver array are integrated there instead. Their
+  // transforms still hold the start of the step here, which the bullet
+  // sweep needs: the soft step may turn a bullet around mid-step.
   void integratePositions(entt::registry& reg, float dt) {
     auto view = reg.view<RigidBody2D, TransformComponent>();
     for (auto [entity, rb, xf] : view.each()) {
-      if (isStatic(rb)) continue;
+      if (isStatic(rb) || isAsleep(rb)) continue;
+      if (rb.bullet) rb.sweepStart = xf.position;
+      if (bodyIndex(entity) != kNoBody) continue;
 
       xf.position += rb.velocity * dt;
-      xf.rotation += rb.angularVelocity * dt;
-
-      constexpr float TWO_PI = 2.0f * 3.14159265f;
-      if (xf.rotation > 3.14159265f)       xf.rotation -= TWO_PI;
-      else if (xf.rotation < -3.14159265f) xf.rotation += TWO_PI;
+      xf.rotation  = wrapAngle(xf.rotation + rb.angularVelocity * dt);
     }
   }
 
@@ -136,47 +467,62 @@ private:
   }
 
   void preStep(SolverContact& sc, float dt) {
-    auto& xfA = *sc.xfA;
-    auto& rbA = *sc.rbA;
-    auto& xfB = *sc.xfB;
-    auto& rbB = *sc.rbB;
-    auto& cc  = *sc.cc;
+    const SolverBody& A = m_bodies[sc.a];
+    const SolverBody& B = m_bodies[sc.b];
+    auto& cc = *sc.cc;
 
     for (int i = 0; i < cc.pointCount; ++i) {
       auto& pt = cc.points[i];
 
-      pt.rA = pt.position - xfA.position;
-      pt.rB = pt.position - xfB.position;
+      pt.rA = pt.position - A.position;
+      pt.rB = pt.position - B.position;
 
       float rnA = cross2(pt.rA, cc.normal);
       float rnB = cross2(pt.rB, cc.normal);
-      float kn = rbA.invMass + rbB.invMass
-               + rbA.invInertia * rnA * rnA
-               + rbB.invInertia * rnB * rnB;
+      float kn = A.invMass + B.invMass
+               + A.invInertia * rnA * rnA
+               + B.invInertia * rnB * rnB;
       pt.normalMass = (kn > 0.f) ? 1.f / kn : 0.f;
 
       glm::vec2 tangent = { -cc.normal.y, cc.normal.x };
       float rtA = cross2(pt.rA, tangent);
       float rtB = cross2(pt.rB, tangent);
-      float kt = rbA.invMass + rbB.invMass
-               + rbA.invInertia * rtA * rtA
-               + rbB.invInertia * rtB * rtB;
+      float kt = A.invMass + B.invMass
+               + A.invInertia * rtA * rtA
+               + B.invInertia * rtB * rtB;
       pt.tangentMass = (kt > 0.f) ? 1.f / kt : 0.f;
 
-      glm::vec2 vA = rbA.velocity + cross2(rbA.angularVelocity, pt.rA);
-      glm::vec2 vB = rbB.velocity + cross2(rbB.angularVelocity, pt.rB);
+      glm::vec2 vA = A.velocity + cross2(A.angularVelocity, pt.rA);
+      glm::vec2 vB = B.velocity + cross2(B.angularVelocity, pt.rB);
       float vRel = glm::dot(vB - vA, cc.normal);
 
+      // A speculative point may close its gap this step but no more, unless
+      // the bodies would reach each other and bounce.
+      bool reaches = pt.penetration >= 0.f || vRel * dt < pt.penetration;
       pt.velocityBias = 0.f;
-      if (vRel < -restitutionThreshold)
+      if (reaches && cc.restitution > 0.f && vRel < -restitutionThreshold)
         pt.velocityBias = -cc.restitution * vRel;
+      else if (pt.penetration < 0.f)
+        pt.velocityBias = pt.penetration / dt;
+
+      pt.adjustedSeparation = -pt.penetration - glm::dot(pt.rB - pt.rA, cc.normal);
+      pt.relativeVelocity   = vRel;
+      pt.maxNormalImpulse   = 0.f;
     }
   }
 
+  // The passes work on copies of the solver bodies and only store them
+  // back for moving bodies; another task may be reading the same static or
+  // kinematic body.
+  void storeVelocity(uint32_t i, const SolverBody& b) {
+    m_bodies[i].velocity        = b.velocity;
+    m_bodies[i].angularVelocity = b.angularVelocity;
+  }
+
   void warmStart(SolverContact& sc) {
-    auto& rbA = *sc.rbA;
-    auto& rbB = *sc.rbB;
-    auto& cc  = *sc.cc;
+    SolverBody A = m_bodies[sc.a];
+    SolverBody B = m_bodies[sc.b];
+    auto& cc = *sc.cc;
 
     glm::vec2 tangent = { -cc.normal.y, cc.normal.x };
 
@@ -185,25 +531,28 @@ private:
       glm::vec2 P = pt.normalImpulse * cc.normal
                    + pt.tangentImpulse * tangent;
 
-      rbA.velocity        -= rbA.invMass    * P;
-      rbA.angularVelocity -= rbA.invInertia * cross2(pt.rA, P);
-      rbB.velocity        += rbB.invMass    * P;
-      rbB.angularVelocity += rbB.invInertia * cross2(pt.rB, P);
+      A.velocity        -= A.invMass       * P;
+      A.angularVelocity -= A.invInertia * cross2(pt.rA, P);
+      B.velocity        += B.invMass       * P;
+      B.angularVelocity += B.invInertia * cross2(pt.rB, P);
     }
+
+    if (sc.moveA) storeVelocity(sc.a, A);
+    if (sc.moveB) storeVelocity(sc.b, B);
   }
 
   void solveVelocity(SolverContact& sc) {
-    auto& rbA = *sc.rbA;
-    auto& rbB = *sc.rbB;
-    auto& cc  = *sc.cc;
+    SolverBody A = m_bodies[sc.a];
+    SolverBody B = m_bodies[sc.b];
+    auto& cc = *sc.cc;
 
     glm::vec2 tangent = { -cc.normal.y, cc.normal.x };
 
     for (int i = 0; i < cc.pointCount; ++i) {
       auto& pt = cc.points[i];
 
-      glm::vec2 vA = rbA.velocity + cross2(rbA.angularVelocity, pt.rA);
-      glm::vec2 vB = rbB.velocity + cross2(rbB.angularVelocity, pt.rB);
+      glm::vec2 vA = A.velocity + cross2(A.angularVelocity, pt.rA);
+      glm::vec2 vB = B.velocity + cross2(B.angularVelocity, pt.rB);
       float vt = glm::dot(vB - vA, tangent);
 
       float lambda = pt.tangentMass * (-vt);
@@ -215,17 +564,17 @@ private:
       lambda = pt.tangentImpulse - oldAccum;
 
       glm::vec2 P = lambda * tangent;
-      rbA.velocity        -= rbA.invMass    * P;
-      rbA.angularVelocity -= rbA.invInertia * cross2(pt.rA, P);
-      rbB.velocity        += rbB.invMass    * P;
-      rbB.angularVelocity += rbB.invInertia * cross2(pt.rB, P);
+      A.velocity        -= A.invMass       * P;
+      A.angularVelocity -= A.invInertia * cross2(pt.rA, P);
+      B.velocity        += B.invMass       * P;
+      B.angularVelocity += B.invInertia * cross2(pt.rB, P);
     }
 
     for (int i = 0; i < cc.pointCount; ++i) {
       auto& pt = cc.points[i];
 
-      glm::vec2 vA = rbA.velocity + cross2(rbA.angularVelocity, pt.rA);
-      glm::vec2 vB = rbB.velocity + cross2(rbB.angularVelocity, pt.rB);
+      glm::vec2 vA = A.velocity + cross2(A.angularVelocity, pt.rA);
+      glm::vec2 vB = B.velocity + cross2(B.angularVelocity, pt.rB);
       float vn = glm::dot(vB - vA, cc.normal);
 
       float lambda = pt.normalMass * (-vn + pt.velocityBias);
@@ -235,33 +584,34 @@ private:
       lambda = pt.normalImpulse - oldAccum;
 
       glm::vec2 P = lambda * cc.normal;
-      rbA.velocity        -= rbA.invMass    * P;
-      rbA.angularVelocity -= rbA.invInertia * cross2(pt.rA, P);
-      rbB.velocity        += rbB.invMass    * P;
-      rbB.angularVelocity += rbB.invInertia * cross2(pt.rB, P);
+      A.velocity        -= A.invMass       * P;
+      A.angularVelocity -= A.invInertia * cross2(pt.rA, P);
+      B.velocity        += B.invMass       * P;
+      B.angularVelocity += B.invInertia * cross2(pt.rB, P);
     }
+
+    if (sc.moveA) storeVelocity(sc.a, A);
+    if (sc.moveB) storeVelocity(sc.b, B);
   }
 
   void solvePosition(SolverContact& sc) {
-    auto& xfA = *sc.xfA;
-    auto& rbA = *sc.rbA;
-    auto& xfB = *sc.xfB;
-    auto& rbB = *sc.rbB;
-    auto& cc  = *sc.cc;
+    SolverBody A = m_bodies[sc.a];
+    SolverBody B = m_bodies[sc.b];
+    auto& cc = *sc.cc;
 
     for (int i = 0; i < cc.pointCount; ++i) {
       auto& pt = cc.points[i];
 
-      float cosA = std::cos(xfA.rotation), sinA = std::sin(xfA.rotation);
-      float cosB = std::cos(xfB.rotation), sinB = std::sin(xfB.rotation);
+      float cosA = std::cos(A.rotation), sinA = std::sin(A.rotation);
+      float cosB = std::cos(B.rotation), sinB = std::sin(B.rotation);
 
       glm::vec2 rA = { cosA * pt.localA.x - sinA * pt.localA.y,
                         sinA * pt.localA.x + cosA * pt.localA.y };
       glm::vec2 rB = { cosB * pt.localB.x - sinB * pt.localB.y,
                         sinB * pt.localB.x + cosB * pt.localB.y };
 
-      glm::vec2 worldA = xfA.position + rA;
-      glm::vec2 worldB = xfB.position + rB;
+      glm::vec2 worldA = A.position + rA;
+      glm::vec2 worldB = B.position + rB;
 
       float separation = glm::dot(worldB - worldA, cc.normal);
 
@@ -270,18 +620,523 @@ private:
 
       float rnA = cross2(rA, cc.normal);
       float rnB = cross2(rB, cc.normal);
-      float K = rbA.invMass + rbB.invMass
-              + rbA.invInertia * rnA * rnA
-              + rbB.invInertia * rnB * rnB;
+      float K = A.invMass + B.invMass
+              + A.invInertia * rnA * rnA
+              + B.invInertia * rnB * rnB;
       if (K <= 0.f) continue;
 
       float correction = std::min(-baumgarte * C / K, maxPositionCorrection);
 
       glm::vec2 P = correction * cc.normal;
-      xfA.position -= rbA.invMass * P;
-      xfB.position += rbB.invMass * P;
-      xfA.rotation -= rbA.invInertia * rnA * correction;
-      xfB.rotation += rbB.invInertia * rnB * correction;
+      A.position -= A.invMass * P;
+      A.rotation -= A.invInertia * rnA * correction;
+      B.position += B.invMass * P;
+      B.rotation += B.invInertia * rnB * correction;
+    }
+
+    if (sc.moveA) storePose(sc.a, A);
+    if (sc.moveB) storePose(sc.b, B);
+  }
+
+  void storePose(uint32_t i, const SolverBody& b) {
+    m_bodies[i].position = b.position;
+    m_bodies[i].rotation = b.rotation;
+  }
+
+  static glm::vec2 rotate(const glm::vec2& q, const glm::vec2& v) {
+    return { q.x * v.x - q.y * v.y, q.y * v.x + q.x * v.y };
+  }
+
+  // A gap closes at most this substep; overlap is pushed out by the spring
+  // when useBias is set, and only stopped from growing in the relax pass.
+  void solveSoft(SolverContact& sc, bool useBias) {
+    SolverBody A = m_bodies[sc.a];
+    SolverBody B = m_bodies[sc.b];
+    auto& cc = *sc.cc;
+
+    const Softness& soft = (A.invMass == 0.f || B.invMass == 0.f)
+                         ? m_staticSoft : m_contactSoft;
+    const glm::vec2 dp = B.deltaPosition - A.deltaPosition;
+
+    for (int i = 0; i < cc.pointCount; ++i) {
+      auto& pt = cc.points[i];
+
+      glm::vec2 d = dp + rotate(B.deltaRotation, pt.rB)
+                       - rotate(A.deltaRotation, pt.rA);
+      float separation = glm::dot(d, cc.normal) + pt.adjustedSeparation;
+
+      float bias = 0.f, massScale = 1.f, impulseScale = 0.f;
+      if (separation > 0.f) {
+        bias = separation * m_invH;
+      } else if (useBias) {
+        bias = std::max(soft.biasRate * separation, -contactPushVelocity);
+        massScale    = soft.massScale;
+        impulseScale = soft.impulseScale;
+      }
+
+      glm::vec2 vA = A.velocity + cross2(A.angularVelocity, pt.rA);
+      glm::vec2 vB = B.velocity + cross2(B.angularVelocity, pt.rB);
+      float vn = glm::dot(vB - vA, cc.normal);
+
+      float lambda = -pt.normalMass * massScale * (vn + bias)
+                   - impulseScale * pt.normalImpulse;
+
+      float oldAccum = pt.normalImpulse;
+      pt.normalImpulse = std::max(oldAccum + lambda, 0.f);
+      lambda = pt.normalImpulse - oldAccum;
+      pt.maxNormalImpulse = std::max(pt.maxNormalImpulse, lambda);
+
+      glm::vec2 P = lambda * cc.normal;
+      A.velocity        -= A.invMass       * P;
+      A.angularVelocity -= A.invInertia * cross2(pt.rA, P);
+      B.velocity        += B.invMass       * P;
+      B.angularVelocity += B.invInertia * cross2(pt.rB, P);
     }
+
+    glm::vec2 tangent = { -cc.normal.y, cc.normal.x };
+
+    for (int i = 0; i < cc.pointCount; ++i) {
+      auto& pt = cc.points[i];
+
+      glm::vec2 vA = A.velocity + cross2(A.angularVelocity, pt.rA);
+      glm::vec2 vB = B.velocity + cross2(B.angularVelocity, pt.rB);
+      float vt = glm::dot(vB - vA, tangent);
+
+      float lambda = pt.tangentMass * (-vt);
+
+      float maxFriction = cc.friction * pt.normalImpulse;
+      float oldAccum = pt.tangentImpulse;
+      pt.tangentImpulse = glm::clamp(oldAccum + lambda,
+                                      -maxFriction, maxFriction);
+      lambda = pt.tangentImpulse - oldAccum;
+
+      glm::vec2 P = lambda * tangent;
+      A.velocity        -= A.invMass       * P;
+      A.angularVelocity -= A.invInertia * cross2(pt.rA, P);
+      B.velocity        += B.invMass       * P;
+      B.angularVelocity += B.invInertia * cross2(pt.rB, P);
+    }
+
+    if (sc.moveA) storeVelocity(sc.a, A);
+    if (sc.moveB) storeVelocity(sc.b, B);
+  }
+
+  // Points that came in fast and were pushed at some point in the step
+  // leave at restitution times the speed they came in with.
+  void applyRestitution(SolverContact& sc) {
+    auto& cc = *sc.cc;
+    if (cc.restitution == 0.f) return;
+    SolverBody A = m_bodies[sc.a];
+    SolverBody B = m_bodies[sc.b];
+
+    for (int i = 0; i < cc.pointCount; ++i) {
+      auto& pt = cc.points[i];
+      if (pt.relativeVelocity > -restitutionThreshold ||
+          pt.maxNormalImpulse == 0.f)
+        continue;
+
+      glm::vec2 vA = A.velocity + cross2(A.angularVelocity, pt.rA);
+      glm::vec2 vB = B.velocity + cross2(B.angularVelocity, pt.rB);
+      float vn = glm::dot(vB - vA, cc.normal);
+
+      float lambda = -pt.normalMass * (vn + cc.restitution * pt.relativeVelocity);
+
+      float oldAccum = pt.normalImpulse;
+      pt.normalImpulse = std::max(oldAccum + lambda, 0.f);
+      lambda = pt.normalImpulse - oldAccum;
+
+      glm::vec2 P = lambda * cc.normal;
+      A.velocity        -= A.invMass       * P;
+      A.angularVelocity -= A.invInertia * cross2(pt.rA, P);
+      B.velocity        += B.invMass       * P;
+      B.angularVelocity += B.invInertia * cross2(pt.rB, P);
+    }
+
+    if (sc.moveA) storeVelocity(sc.a, A);
+    if (sc.moveB) storeVelocity(sc.b, B);
+  }
+
+  void packWide() {
+    m_wide.clear();
+    uint32_t begin = 0;
+    for (int c = 0; c < kColorCount; ++c) {
+      for (uint32_t i = begin; i < m_colorEnd[c]; i += 4)
+        packBatch(i, std::min(m_colorEnd[c], i + 4));
+      m_wideEnd[c] = static_cast<uint32_t>(m_wide.size());
+      begin = m_colorEnd[c];
+    }
+  }
+
+  void packBatch(uint32_t begin, uint32_t end) {
+    WideContact& wc = m_wide.emplace_back();
+    float nx[4] = {}, ny[4] = {}, mu[4] = {}, e[4] = {};
+    float imA[4] = {}, iiA[4] = {}, imB[4] = {}, iiB[4] = {};
+    float lax[2][4] = {}, lay[2][4] = {}, lbx[2][4] = {}, lby[2][4] = {};
+    float jn[2][4] = {}, jt[2][4] = {}, live[2][4] = {};
+    wc.moveA = wc.moveB = 0;
+
+    for (uint32_t i = 0; i < 4; ++i) {
+      if (begin + i >= end) {
+        wc.cc[i] = nullptr;
+        wc.a[i]  = wc.b[i] = 0;
+        continue;
+      }
+      const SolverContact& sc = m_solverContacts[begin + i];
+      const ContactConstraint& cc = *sc.cc;
+      const SolverBody& A = m_bodies[sc.a];
+      const SolverBody& B = m_bodies[sc.b];
+      wc.cc[i] = sc.cc;
+      wc.a[i]  = sc.a;
+      wc.b[i]  = sc.b;
+      wc.moveA |= sc.moveA << i;
+      wc.moveB |= sc.moveB << i;
+      nx[i]  = cc.normal.x;   ny[i]  = cc.normal.y;
+      mu[i]  = cc.friction;   e[i]   = cc.restitution;
+      imA[i] = A.invMass;     iiA[i] = A.invInertia;
+      imB[i] = B.invMass;     iiB[i] = B.invInertia;
+      for (int j = 0; j < cc.pointCount; ++j) {
+        const ContactPoint& pt = cc.points[j];
+        lax[j][i] = pt.localA.x;   lay[j][i] = pt.localA.y;
+        lbx[j][i] = pt.localB.x;   lby[j][i] = pt.localB.y;
+        jn[j][i]  = pt.normalImpulse;
+        jt[j][i]  = pt.tangentImpulse;
+        live[j][i] = 1.f;
+      }
+    }
+
+    wc.nx = Float4::load(nx);         wc.ny = Float4::load(ny);
+    wc.friction    = Float4::load(mu);
+    wc.restitution = Float4::load(e);
+    wc.invMassA = Float4::load(imA);  wc.invIA = Float4::load(iiA);
+    wc.invMassB = Float4::load(imB);  wc.invIB = Float4::load(iiB);
+    for (int j = 0; j < 2; ++j) {
+      WidePoint& pt = wc.pt[j];
+      pt.localAx = Float4::load(lax[j]);  pt.localAy = Float4::load(lay[j]);
+      pt.localBx = Float4::load(lbx[j]);  pt.localBy = Float4::load(lby[j]);
+      pt.normalImpulse  = Float4::load(jn[j]);
+      pt.tangentImpulse = Float4::load(jt[j]);
+      pt.live = Float4(0.f) < Float4::load(live[j]);
+    }
+  }
+
+  // Accumulated impulses go back to the contacts for next step's warm start
+  // and for anyone reading them.
+  void storeImpulses() {
+    for (const WideContact& wc : m_wide) {
+      for (int j = 0; j < 2; ++j) {
+        float jn[4], jt[4];
+        wc.pt[j].normalImpulse.store(jn);
+        wc.pt[j].tangentImpulse.store(jt);
+        for (int i = 0; i < 4; ++i) {
+          if (!wc.cc[i] || j >= wc.cc[i]->pointCount) continue;
+          wc.cc[i]->points[j].normalImpulse  = jn[i];
+          wc.cc[i]->points[j].tangentImpulse = jt[i];
+        }
+      }
+    }
+  }
+
+  struct WideBody {
+    Float4 vx, vy, w;
+  };
+
+  struct WidePose {
+    Float4 px, py, angle;
+  };
+
+  WideBody gatherVelocity(const uint32_t (&idx)[4]) const {
+    float vx[4], vy[4], w[4];
+    for (int i = 0; i < 4; ++i) {
+      const SolverBody& b = m_bodies[idx[i]];
+      vx[i] = b.velocity.x;
+      vy[i] = b.velocity.y;
+      w[i]  = b.angularVelocity;
+    }
+    return { Float4::load(vx), Float4::load(vy), Float4::load(w) };
+  }
+
+  void scatterVelocity(const uint32_t (&idx)[4], int move, const WideBody& b) {
+    float vx[4], vy[4], w[4];
+    b.vx.store(vx);  b.vy.store(vy);  b.w.store(w);
+    for (int i = 0; i < 4; ++i) {
+      if (!(move & (1 << i))) continue;
+      m_bodies[idx[i]].velocity        = { vx[i], vy[i] };
+      m_bodies[idx[i]].angularVelocity = w[i];
+    }
+  }
+
+  WidePose gatherPose(const uint32_t (&idx)[4]) const {
+    float px[4], py[4], a[4];
+    for (int i = 0; i < 4; ++i) {
+      const SolverBody& b = m_bodies[idx[i]];
+      px[i] = b.position.x;
+      py[i] = b.position.y;
+      a[i]  = b.rotation;
+    }
+    return { Float4::load(px), Float4::load(py), Float4::load(a) };
+  }
+
+  void scatterPose(const uint32_t (&idx)[4], int move, const WidePose& p) {
+    float px[4], py[4], a[4];
+    p.px.store(px);  p.py.store(py);  p.angle.store(a);
+    for (int i = 0; i < 4; ++i) {
+      if (!(move & (1 << i))) continue;
+      m_bodies[idx[i]].position = { px[i], py[i] };
+      m_bodies[idx[i]].rotation = a[i];
+    }
+  }
+
+  // Applies -P at r; body B is handed the negated impulse.
+  static void applyImpulse(WideBody& b, Float4 invMass, Float4 invI,
+                           Float4 rx, Float4 ry, Float4 px, Float4 py) {
+    b.vx = b.vx - invMass * px;
+    b.vy = b.vy - invMass * py;
+    b.w  = b.w  - invI * (rx * py - ry * px);
+  }
+
+  static Float4 relativeVelocity(const WideBody& A, const WideBody& B,
+                                 const WidePoint& pt, Float4 dx, Float4 dy) {
+    Float4 vx = (B.vx - B.w * pt.rBy) - (A.vx - A.w * pt.rAy);
+    Float4 vy = (B.vy + B.w * pt.rBx) - (A.vy + A.w * pt.rAx);
+    return vx * dx + vy * dy;
+  }
+
+  void preStepWide(WideContact& wc, float dt) const {
+    const WidePose A  = gatherPose(wc.a);
+    const WidePose B  = gatherPose(wc.b);
+    const WideBody vA = gatherVelocity(wc.a);
+    const WideBody vB = gatherVelocity(wc.b);
+    const Float4 zero(0.f);
+    const Float4 tx = -wc.ny, ty = wc.nx;
+
+    for (int j = 0; j < 2; ++j) {
+      WidePoint& pt = wc.pt[j];
+      float px[4] = {}, py[4] = {}, pen[4] = {};
+      for (int i = 0; i < 4; ++i) {
+        if (!wc.cc[i] || j >= wc.cc[i]->pointCount) continue;
+        const ContactPoint& cp = wc.cc[i]->points[j];
+        px[i]  = cp.position.x;
+        py[i]  = cp.position.y;
+        pen[i] = cp.penetration;
+      }
+      const Float4 Px = Float4::load(px), Py = Float4::load(py);
+      const Float4 penetration = Float4::load(pen);
+      pt.rAx = Px - A.px;  pt.rAy = Py - A.py;
+      pt.rBx = Px - B.px;  pt.rBy = Py - B.py;
+
+      const Float4 rnA = pt.rAx * wc.ny - pt.rAy * wc.nx;
+      const Float4 rnB = pt.rBx * wc.ny - pt.rBy * wc.nx;
+      const Float4 kn = wc.invMassA + wc.invMassB
+                      + wc.invIA * rnA * rnA + wc.invIB * rnB * rnB;
+      pt.normalMass = select(pt.live & (kn > zero), Float4(1.f) / kn, zero);
+
+      const Float4 rtA = pt.rAx * ty - pt.rAy * tx;
+      const Float4 rtB = pt.rBx * ty - pt.rBy * tx;
+      const Float4 kt = wc.invMassA + wc.invMassB
+                      + wc.invIA * rtA * rtA + wc.invIB * rtB * rtB;
+      pt.tangentMass = select(pt.live & (kt > zero), Float4(1.f) / kt, zero);
+
+      const Float4 vRel = relativeVelocity(vA, vB, pt, wc.nx, wc.ny);
+      const Float4 reaches = (penetration >= zero) |
+                             (vRel * Float4(dt) < penetration);
+      const Float4 bounce = reaches & (wc.restitution > zero) &
+                            (vRel < Float4(-restitutionThreshold));
+      pt.bias = select(bounce, -wc.restitution * vRel,
+                       select(penetration < zero, penetration / Float4(dt), zero));
+
+      pt.adjustedSeparation = -penetration - ((pt.rBx - pt.rAx) * wc.nx
+                                            + (pt.rBy - pt.rAy) * wc.ny);
+      pt.relativeVelocity   = vRel;
+      pt.maxNormalImpulse   = zero;
+    }
+  }
+
+  void warmStartWide(WideContact& wc) {
+    WideBody A = gatherVelocity(wc.a);
+    WideBody B = gatherVelocity(wc.b);
+    const Float4 tx = -wc.ny, ty = wc.nx;
+
+    for (const WidePoint& pt : wc.pt) {
+      const Float4 Px = pt.normalImpulse * wc.nx + pt.tangentImpulse * tx;
+      const Float4 Py = pt.normalImpulse * wc.ny + pt.tangentImpulse * ty;
+      applyImpulse(A, wc.invMassA, wc.invIA, pt.rAx, pt.rAy, Px, Py);
+      applyImpulse(B, wc.invMassB, wc.invIB, pt.rBx, pt.rBy, -Px, -Py);
+    }
+
+    scatterVelocity(wc.a, wc.moveA, A);
+    scatterVelocity(wc.b, wc.moveB, B);
+  }
+
+  void solveVelocityWide(WideContact& wc) {
+    WideBody A = gatherVelocity(wc.a);
+    WideBody B = gatherVelocity(wc.b);
+    const Float4 tx = -wc.ny, ty = wc.nx;
+
+    for (WidePoint& pt : wc.pt) {
+      const Float4 vt = relativeVelocity(A, B, pt, tx, ty);
+      const Float4 maxFriction = wc.friction * pt.normalImpulse;
+      const Float4 oldAccum = pt.tangentImpulse;
+      pt.tangentImpulse = max(min(oldAccum - pt.tangentMass * vt, maxFriction),
+                              -maxFriction);
+      const Float4 lambda = pt.tangentImpulse - oldAccum;
+      applyImpulse(A, wc.invMassA, wc.invIA, pt.rAx, pt.rAy, lambda * tx, lambda * ty);
+      applyImpulse(B, wc.invMassB, wc.invIB, pt.rBx, pt.rBy, -lambda * tx, -lambda * ty);
+    }
+
+    for (WidePoint& pt : wc.pt) {
+      const Float4 vn = relativeVelocity(A, B, pt, wc.nx, wc.ny);
+      const Float4 oldAccum = pt.normalImpulse;
+      pt.normalImpulse = max(oldAccum + pt.normalMass * (pt.bias - vn), Float4(0.f));
+      const Float4 lambda = pt.normalImpulse - oldAccum;
+      applyImpulse(A, wc.invMassA, wc.invIA, pt.rAx, pt.rAy, lambda * wc.nx, lambda * wc.ny);
+      applyImpulse(B, wc.invMassB, wc.invIB, pt.rBx, pt.rBy, -lambda * wc.nx, -lambda * wc.ny);
+    }
+
+    scatterVelocity(wc.a, wc.moveA, A);
+    scatterVelocity(wc.b, wc.moveB, B);
+  }
+
+  static void rotate(const WidePose& p, Float4 lx, Float4 ly,
+                     Float4& rx, Float4& ry) {
+    Float4 sn, cs;
+    sincos(p.angle, sn, cs);
+    rx = cs * lx - sn * ly;
+    ry = sn * lx + cs * ly;
+  }
+
+  void solvePositionWide(WideContact& wc) {
+    WidePose A = gatherPose(wc.a);
+    WidePose B = gatherPose(wc.b);
+    const Float4 zero(0.f);
+
+    for (const WidePoint& pt : wc.pt) {
+      if (!mask(pt.live)) continue;
+      Float4 rAx, rAy, rBx, rBy;
+      rotate(A, pt.localAx, pt.localAy, rAx, rAy);
+      rotate(B, pt.localBx, pt.localBy, rBx, rBy);
+
+      const Float4 separation = ((B.px + rBx) - (A.px + rAx)) * wc.nx
+                              + ((B.py + rBy) - (A.py + rAy)) * wc.ny;
+      const Float4 C = min(separation + Float4(slop), zero);
+
+      const Float4 rnA = rAx * wc.ny - rAy * wc.nx;
+      const Float4 rnB = rBx * wc.ny - rBy * wc.nx;
+      const Float4 K = wc.invMassA + wc.invMassB
+                     + wc.invIA * rnA * rnA + wc.invIB * rnB * rnB;
+
+      const Float4 active = pt.live & (C < zero) & (K > zero);
+      const Float4 correction = select(active,
+        min(Float4(-baumgarte) * C / K, Float4(maxPositionCorrection)), zero);
+
+      const Float4 Px = correction * wc.nx, Py = correction * wc.ny;
+      A.px    = A.px - wc.invMassA * Px;
+      A.py    = A.py - wc.invMassA * Py;
+      A.angle = A.angle - wc.invIA * rnA * correction;
+      B.px    = B.px + wc.invMassB * Px;
+      B.py    = B.py + wc.invMassB * Py;
+      B.angle = B.angle + wc.invIB * rnB * correction;
+    }
+
+    scatterPose(wc.a, wc.moveA, A);
+    scatterPose(wc.b, wc.moveB, B);
+  }
+
+  struct WideDelta {
+    Float4 px, py, qc, qs;
+  };
+
+  WideDelta gatherDelta(const uint32_t (&idx)[4]) const {
+    float px[4], py[4], qc[4], qs[4];
+    for (int i = 0; i < 4; ++i) {
+      const SolverBody& b = m_bodies[idx[i]];
+      px[i] = b.deltaPosition.x;
+      py[i] = b.deltaPosition.y;
+      qc[i] = b.deltaRotation.x;
+      qs[i] = b.deltaRotation.y;
+    }
+    return { Float4::load(px), Float4::load(py), Float4::load(qc), Float4::load(qs) };
+  }
+
+  void solveSoftWide(WideContact& wc, bool useBias) {
+    WideBody A = gatherVelocity(wc.a);
+    WideBody B = gatherVelocity(wc.b);
+    const WideDelta dA = gatherDelta(wc.a);
+    const WideDelta dB = gatherDelta(wc.b);
+    const Float4 zero(0.f), one(1.f);
+    const Float4 tx = -wc.ny, ty = wc.nx;
+
+    const Float4 fixed = (wc.invMassA == zero) | (wc.invMassB == zero);
+    const Float4 biasRate = select(fixed, Float4(m_staticSoft.biasRate),
+                                          Float4(m_contactSoft.biasRate));
+    const Float4 softMass = select(fixed, Float4(m_staticSoft.massScale),
+                                          Float4(m_contactSoft.massScale));
+    const Float4 softImpulse = select(fixed, Float4(m_staticSoft.impulseScale),
+                                             Float4(m_contactSoft.impulseScale));
+    const Float4 dpx = dB.px - dA.px, dpy = dB.py - dA.py;
+
+    for (WidePoint& pt : wc.pt) {
+      const Float4 dx = dpx + (dB.qc * pt.rBx - dB.qs * pt.rBy)
+                            - (dA.qc * pt.rAx - dA.qs * pt.rAy);
+      const Float4 dy = dpy + (dB.qs * pt.rBx + dB.qc * pt.rBy)
+                            - (dA.qs * pt.rAx + dA.qc * pt.rAy);
+      const Float4 separation = dx * wc.nx + dy * wc.ny + pt.adjustedSeparation;
+      const Float4 gap = separation > zero;
+
+      Float4 bias = select(gap, separation * Float4(m_invH), zero);
+      Float4 massScale = one, impulseScale = zero;
+      if (useBias) {
+        const Float4 push = max(biasRate * separation, Float4(-contactPushVelocity));
+        bias         = select(gap, bias, push);
+        massScale    = select(gap, one, softMass);
+        impulseScale = select(gap, zero, softImpulse);
+      }
+
+      const Float4 vn = relativeVelocity(A, B, pt, wc.nx, wc.ny);
+      const Float4 oldAccum = pt.normalImpulse;
+      pt.normalImpulse = max(oldAccum - pt.normalMass * massScale * (vn + bias)
+                                      - impulseScale * oldAccum, zero);
+      const Float4 lambda = pt.normalImpulse - oldAccum;
+      pt.maxNormalImpulse = max(pt.maxNormalImpulse, lambda);
+      applyImpulse(A, wc.invMassA, wc.invIA, pt.rAx, pt.rAy, lambda * wc.nx, lambda * wc.ny);
+      applyImpulse(B, wc.invMassB, wc.invIB, pt.rBx, pt.rBy, -lambda * wc.nx, -lambda * wc.ny);
+    }
+
+    for (WidePoint& pt : wc.pt) {
+      const Float4 vt = relativeVelocity(A, B, pt, tx, ty);
+      const Float4 maxFriction = wc.friction * pt.normalImpulse;
+      const Float4 oldAccum = pt.tangentImpulse;
+      pt.tangentImpulse = max(min(oldAccum - pt.tangentMass * vt, maxFriction),
+                              -maxFriction);
+      const Float4 lambda = pt.tangentImpulse - oldAccum;
+      applyImpulse(A, wc.invMassA, wc.invIA, pt.rAx, pt.rAy, lambda * tx, lambda * ty);
+      applyImpulse(B, wc.invMassB, wc.invIB, pt.rBx, pt.rBy, -lambda * tx, -lambda * ty);
+    }
+
+    scatterVelocity(wc.a, wc.moveA, A);
+    scatterVelocity(wc.b, wc.moveB, B);
+  }
+
+  void applyRestitutionWide(WideContact& wc) {
+    const Float4 zero(0.f);
+    if (!mask(wc.restitution > zero)) return;
+    WideBody A = gatherVelocity(wc.a);
+    WideBody B = gatherVelocity(wc.b);
+
+    for (WidePoint& pt : wc.pt) {
+      const Float4 active = (pt.relativeVelocity < Float4(-restitutionThreshold)) &
+                            (pt.maxNormalImpulse > zero);
+      if (!mask(active)) continue;
+      const Float4 vn = relativeVelocity(A, B, pt, wc.nx, wc.ny);
+      const Float4 oldAccum = pt.normalImpulse;
+      pt.normalImpulse = select(active,
+        max(oldAccum - pt.normalMass * (vn + wc.restitution * pt.relativeVelocity), zero),
+        oldAccum);
+      const Float4 lambda = pt.normalImpulse - oldAccum;
+      applyImpulse(A, wc.invMassA, wc.invIA, pt.rAx, pt.rAy, lambda * wc.nx, lambda * wc.ny);
+      applyImpulse(B, wc.invMassB, wc.invIB, pt.rBx, pt.rBy, -lambda * wc.nx, -lambda * wc.ny);
+    }
+
+    scatterVelocity(wc.a, wc.moveA, A);
+    scatterVelocity(wc.b, wc.moveB, B);
   }
 };
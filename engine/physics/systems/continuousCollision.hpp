@@ -0,0 +1,200 @@
+#pragma once
+#include "../physicsSystem.hpp"
+#include "../aabb.hpp"
+#include "../broadphase.hpp"
+#include "../narrowphase.hpp"
+#include "components/transform.hpp"
+#include "components/physics_components.hpp"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Keeps bullets (RigidBody2D::bullet) from tunnelling through static
+// geometry. Add it after the ConstraintSolverSystem: each bullet is swept
+// against the static tree from where the solver found it to where it left
+// it, turning at its angular velocity, and a bullet that would have gone
+// into something is put back at the time of impact and bounced off the
+// surface there. The rest of its step is dropped. Bullets still obey
+// maxLinearSpeed, so raise it on the bodies that need to go fast.
+class ContinuousCollisionSystem : public PhysicsSystem {
+public:
+  float targetSeparation = 0.0025f;  // bullets stop this far short
+  float motionThreshold  = 0.5f;     // of the inner radius; slower steps are left alone
+  int   maxIterations    = 20;
+
+  void fixedUpdate(entt::registry& reg, float dt) override {
+    const auto* bp = reg.ctx().find<Broadphase>();
+    if (!bp) return;
+
+    auto view = reg.view<TransformComponent, RigidBody2D>();
+    for (auto [e, xf, rb] : view.each()) {
+      if (!rb.bullet || !isDynamic(rb) || isAsleep(rb)) continue;
+      const auto* circle = reg.try_get<CircleCollider>(e);
+      const auto* box    = reg.try_get<BoxCollider>(e);
+      const auto* convex = reg.try_get<ConvexCollider>(e);
+      if (!circle && !box && !convex) continue;
+      sweepBullet(reg, *bp, xf, rb, circle, box, convex, dt);
+    }
+  }
+
+  const char* name() const override { return "ContinuousCollision"; }
+
+private:
+  void sweepBullet(const entt::registry& reg, const Broadphase& bp,
+                   TransformComponent& xf, RigidBody2D& rb,
+                   const CircleCollider* circle, const BoxCollider* box,
+                   const ConvexCollider* convex, float dt) {
+    narrowphase::Sweep sweep;
+    sweep.p0 = rb.sweepStart;
+    sweep.a0 = xf.rotation - rb.angularVelocity * dt;
+    sweep.p1 = xf.position;
+    sweep.a1 = xf.rotation;
+
+    auto shape = [&](narrowphase::WorldPoly& p, const TransformComponent& x,
+                     float c, float s) {
+      narrowphase::makeCorePoly(p, x, c, s, circle, box, convex);
+    };
+
+    const float c1 = std::cos(xf.rotation), s1 = std::sin(xf.rotation);
+    shape(m_moving, xf, c1, s1);
+    if (m_moving.count < 1) return;
+
+    float reach = 0.f;
+    for (int i = 0; i < m_moving.count; ++i)
+      reach = std::max(reach, glm::length(m_moving.v[i] - xf.position));
+    reach += m_moving.skin;
+
+    const float inner  = innerRadius(m_moving);
+    const float motion = glm::length(sweep.p1 - sweep.p0)
+                       + std::abs(sweep.a1 - sweep.a0) * reach;
+    if (motion < motionThreshold * inner) return;
+
+    // A bullet touching something at the start of its step hits it there if
+    // it is heading in. If it is not, its spin still can bring it closer,
+    // so a small circle around the centroid is swept against it instead.
+    // That keeps the core from passing through and does not pin a body that
+    // slides or rolls along the surface.
+    const glm::vec2 centroid =
+      narrowphase::rotateInv(m_moving.centroid - xf.position, c1, s1);
+    auto core = [&](narrowphase::WorldPoly& p, const TransformComponent& x,
+                    float c, float s) {
+      if (p.v.empty()) {
+        p.v.resize(1);
+        p.n.resize(1);
+      }
+      p.count  = 1;
+      p.v[0]   = x.position + narrowphase::rotate(centroid, c, s);
+      p.n[0]   = { 0.f, 1.f };
+      p.skin   = 0.25f * inner;
+    };
+
+    AABB swept = coreBounds(m_moving);
+    TransformComponent start = xf;
+    start.position = sweep.p0;
+    start.rotation = sweep.a0;
+    shape(m_moving, start, std::cos(start.rotation), std::sin(start.rotation));
+    swept = AABB::combine(swept, coreBounds(m_moving));
+
+    narrowphase::TimeOfImpact first;
+    const RigidBody2D* surface = nullptr;
+    bp.staticTree().query(swept, [&](int32_t id) {
+      const entt::entity other = bp.staticTree().entity(id);
+      const auto* orb = reg.try_get<RigidBody2D>(other);
+      const auto* oxf = reg.try_get<TransformComponent>(other);
+      if (!orb || !oxf || !shouldCollide(rb.filter, orb->filter)) return true;
+
+      const auto* oc = reg.try_get<CircleCollider>(other);
+      const auto* ob = reg.try_get<BoxCollider>(other);
+      const auto* ov = reg.try_get<ConvexCollider>(other);
+      if (!oc && !ob && !ov) return true;
+      narrowphase::makeCorePoly(m_fixed, *oxf, std::cos(oxf->rotation),
+                                std::sin(oxf->rotation), oc, ob, ov);
+      if (m_fixed.count < 1) return true;
+
+      narrowphase::TimeOfImpact toi;
+      if (!narrowphase::timeOfImpact(shape, xf, sweep, reach, m_fixed,
+                                     targetSeparation, maxIterations,
+                                     m_moving, toi))
+        return true;
+      if (toi.t == 0.f && !approaching(rb, sweep.p0, toi) &&
+          (!narrowphase::timeOfImpact(core, xf, sweep, reach, m_fixed,
+                                      targetSeparation, maxIterations,
+                                      m_moving, toi) || toi.t == 0.f))
+        return true;
+      if (toi.t < first.t) {
+        first   = toi;
+        surface = orb;
+      }
+      return true;
+    });
+    if (!surface) return;
+
+    xf.position = sweep.p0 + first.t * (sweep.p1 - sweep.p0);
+    xf.rotation = sweep.a0 + first.t * (sweep.a1 - sweep.a0);
+    bounce(rb, *surface, xf.position, first);
+  }
+
+  static glm::vec2 pointVelocity(const RigidBody2D& rb, const glm::vec2& r) {
+    return rb.velocity + rb.angularVelocity * glm::vec2{ -r.y, r.x };
+  }
+
+  static bool approaching(const RigidBody2D& rb, const glm::vec2& origin,
+                          const narrowphase::TimeOfImpact& toi) {
+    return glm::dot(pointVelocity(rb, toi.point - origin), toi.normal) > 0.f;
+  }
+
+  // One contact against an immovable surface, with restitution and
+  // friction mixed the way the discrete contacts mix them.
+  static void bounce(RigidBody2D& rb, const RigidBody2D& surface,
+                     const glm::vec2& origin,
+                     const narrowphase::TimeOfImpact& toi) {
+    const glm::vec2 n = toi.normal;
+    const glm::vec2 r = toi.point - origin;
+    const glm::vec2 v = pointVelocity(rb, r);
+    const float vn = glm::dot(v, n);
+    if (vn <= 0.f) return;
+
+    const float rn = cross2(r, n);
+    const float kn = rb.invMass + rb.invInertia * rn * rn;
+    if (kn <= 0.f) return;
+    const float jn = (1.f + std::max(rb.restitution, surface.restitution)) * vn / kn;
+
+    const glm::vec2 tangent{ -n.y, n.x };
+    const float rt = cross2(r, tangent);
+    const float kt = rb.invMass + rb.invInertia * rt * rt;
+    const float maxFriction = std::sqrt(rb.friction * surface.friction) * jn;
+    const float jt = kt > 0.f
+                   ? std::clamp(-glm::dot(v, tangent) / kt, -maxFriction, maxFriction)
+                   : 0.f;
+
+    const glm::vec2 P = -jn * n + jt * tangent;
+    rb.velocity        += rb.invMass * P;
+    rb.angularVelocity += rb.invInertia * cross2(r, P);
+  }
+
+  static float cross2(const glm::vec2& a, const glm::vec2& b) {
+    return a.x * b.y - a.y * b.x;
+  }
+
+  static AABB coreBounds(const narrowphase::WorldPoly& p) {
+    glm::vec2 mn = p.v[0], mx = p.v[0];
+    for (int i = 1; i < p.count; ++i) {
+      mn = glm::min(mn, p.v[i]);
+      mx = glm::max(mx, p.v[i]);
+    }
+    return { mn - glm::vec2(p.skin), mx + glm::vec2(p.skin) };
+  }
+
+  // Centroid to the nearest face, skin included.
+  static float innerRadius(const narrowphase::WorldPoly& p) {
+    if (p.count < 3) return p.skin;
+    float r = std::numeric_limits<float>::max();
+    for (int i = 0; i < p.count; ++i)
+      r = std::min(r, glm::dot(p.n[i], p.v[i] - p.centroid));
+    return std::max(r, 0.f) + p.skin;
+  }
+
+  narrowphase::WorldPoly m_moving;
+  narrowphase::WorldPoly m_fixed;
+};
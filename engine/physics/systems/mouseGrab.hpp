@@ -2,12 +2,14 @@
 #include "../physicsSystem.hpp"
 #include "../pointerState.hpp"
 #include "constraintSolver.hpp"
+#include "../query.hpp"
 #include "components/transform.hpp"
 #include "components/physics_components.hpp"
 #include <glm/glm.hpp>
 #include <entt/entt.hpp>
 #include <cmath>
 #include <limits>
+#include <vector>
 
 struct MouseGrabState {
   bool          active    = false;
@@ -28,6 +30,7 @@ public:
   float frequency    = 5.f;
   float dampingRatio = 1.f;
   float maxForce     = 500.f;
+  float pickReach    = 0.5f;   // how far past a body's bounds a click may land
 
   void init(entt::registry& reg) override {
     if (!reg.ctx().contains<PointerState>())
@@ -37,11 +40,11 @@ public:
   }
 
   void registerWithSolver(ConstraintSolverSystem& solver) {
-    solver.addVelocityConstraint([](entt::registry& reg) {
+    solver.addVelocityConstraint([&solver](entt::registry& reg) {
       if (!reg.ctx().contains<MouseGrabState>()) return;
       auto& ms = reg.ctx().get<MouseGrabState>();
       if (!ms.active || !reg.valid(ms.grabbed)) return;
-      solveGrabStep(reg, ms);
+      solveGrabStep(reg, ms, solver.velocityOf(reg, ms.grabbed));
     });
   }
 
@@ -67,10 +70,11 @@ public:
 
   const char* name() const override { return "MouseGrab"; }
 
-  static void solveGrabStep(entt::registry& reg, MouseGrabState& ms) {
-    auto& rb = reg.get<RigidBody2D>(ms.grabbed);
+  static void solveGrabStep(entt::registry& reg, MouseGrabState& ms,
+                            ConstraintSolverSystem::VelocityRef v) {
+    const auto& rb = reg.get<RigidBody2D>(ms.grabbed);
 
-    glm::vec2 vAnchor = rb.velocity + cross2(rb.angularVelocity, ms.rArm);
+    glm::vec2 vAnchor = v.linear + cross2(v.angular, ms.rArm);
     glm::vec2 Cdot = vAnchor + ms.bias + ms.gamma * ms.impulseAccum;
     glm::vec2 impulse = -(ms.massMatrix * Cdot);
 
@@ -81,8 +85,8 @@ public:
       ms.impulseAccum *= ms.maxImpulse / mag;
     impulse = ms.impulseAccum - oldAccum;
 
-    rb.velocity        += rb.invMass    * impulse;
-    rb.angularVelocity += rb.invInertia * cross2(ms.rArm, impulse);
+    v.linear  += rb.invMass    * impulse;
+    v.angular += rb.invInertia * cross2(ms.rArm, impulse);
   }
 
 private:
@@ -98,63 +102,30 @@ private:
     entt::entity bestEnt = entt::null;
     glm::vec2 bestLocal{ 0.f };
 
-    auto view = reg.view<TransformComponent, RigidBody2D>();
-    for (auto [e, xf, rb] : view.each()) {
-      if (!isDynamic(rb)) continue;
+    // The tolerance grows shapes past their bounds, so search a little wider.
+    glm::vec2 reach{ pickReach };
+    queryAABB(reg, AABB{ ps.worldPos - reach, ps.worldPos + reach },
+              CollisionFilter{ 0xFFFF, 0xFFFF, 0 }, m_candidates);
+    for (entt::entity e : m_candidates) {
+      if (!isDynamic(reg.get<RigidBody2D>(e))) continue;
 
+      auto& xf = reg.get<TransformComponent>(e);
       glm::vec2 diff = ps.worldPos - xf.position;
+      float cosR = std::cos(-xf.rotation), sinR = std::sin(-xf.rotation);
+      glm::vec2 local = {
+        cosR * diff.x - sinR * diff.y,
+        sinR * diff.x + cosR * diff.y
+      };
       float d2 = glm::dot(diff, diff);
-      bool inside = false;
-
-      if (reg.all_of<CircleCollider>(e)) {
-        auto& c = reg.get<CircleCollider>(e);
-        float r = c.radius * std::max(xf.scale.x, xf.scale.y);
-        inside = d2 <= r * r * 1.2f;
-      }
-      if (!inside && reg.all_of<BoxCollider>(e)) {
-        auto& bc = reg.get<BoxCollider>(e);
-        float cosR = std::cos(-xf.rotation), sinR = std::sin(-xf.rotation);
-        glm::vec2 local = {
-          cosR * diff.x - sinR * diff.y,
-          sinR * diff.x + cosR * diff.y
-        };
-        glm::vec2 half = bc.halfExtents * xf.scale;
-        inside = std::abs(local.x) <= half.x * 1.1f
-              && std::abs(local.y) <= half.y * 1.1f;
-      }
-      if (!inside && reg.all_of<ConvexCollider>(e)) {
-        auto& pc = reg.get<ConvexCollider>(e);
-        if (pc.vertices.size() >= 3) {
-          float cosR = std::cos(-xf.rotation), sinR = std::sin(-xf.rotation);
-          glm::vec2 local = {
-            cosR * diff.x - sinR * diff.y,
-            sinR * diff.x + cosR * diff.y
-          };
-          bool allPos = true, allNeg = true;
-          size_t n = pc.vertices.size();
-          for (size_t i = 0; i < n; ++i) {
-            glm::vec2 a = pc.vertices[i] * xf.scale;
-            glm::vec2 b = pc.vertices[(i + 1) % n] * xf.scale;
-            float cr = (b.x - a.x) * (local.y - a.y) - (b.y - a.y) * (local.x - a.x);
-            if (cr < 0.f) allPos = false;
-            if (cr > 0.f) allNeg = false;
-          }
-          inside = allPos || allNeg;
-        }
-      }
-
-      if (inside && d2 < bestDist2) {
+      if (d2 < bestDist2 && nearShape(reg, e, xf, ps.worldPos, d2, local)) {
         bestDist2 = d2;
         bestEnt   = e;
-        float cosR = std::cos(-xf.rotation), sinR = std::sin(-xf.rotation);
-        bestLocal = {
-          cosR * diff.x - sinR * diff.y,
-          sinR * diff.x + cosR * diff.y
-        };
+        bestLocal = local;
       }
     }
 
     if (bestEnt != entt::null) {
+      wakeBody(reg.get<RigidBody2D>(bestEnt));
       ms.active       = true;
       ms.grabbed      = bestEnt;
       ms.localAnchor  = bestLocal;
@@ -163,9 +134,30 @@ private:
     }
   }
 
+  // Circles count 1.2x their squared radius and boxes 1.1x their half
+  // extents, so a click just off the edge still picks them; convex shapes
+  // need the cursor inside.
+  static bool nearShape(const entt::registry& reg, entt::entity e,
+                        const TransformComponent& xf, const glm::vec2& point,
+                        float d2, const glm::vec2& local) {
+    if (auto* c = reg.try_get<CircleCollider>(e)) {
+      float r = c->radius * std::max(xf.scale.x, xf.scale.y);
+      if (d2 <= r * r * 1.2f) return true;
+    }
+    if (auto* bc = reg.try_get<BoxCollider>(e)) {
+      glm::vec2 half = bc->halfExtents * xf.scale;
+      if (std::abs(local.x) <= half.x * 1.1f
+       && std::abs(local.y) <= half.y * 1.1f) return true;
+    }
+    if (auto* pc = reg.try_get<ConvexCollider>(e))
+      return narrowphase::testPoint(xf, nullptr, nullptr, pc, point);
+    return false;
+  }
+
   void preStepGrab(entt::registry& reg, MouseGrabState& ms, float dt) {
     auto& xf = reg.get<TransformComponent>(ms.grabbed);
     auto& rb = reg.get<RigidBody2D>(ms.grabbed);
+    wakeBody(rb);   // held bodies never settle, however still the pointer
 
     float cosR = std::cos(xf.rotation), sinR = std::sin(xf.rotation);
     ms.rArm = glm::vec2{
@@ -208,4 +200,6 @@ private:
     rb.velocity        += rb.invMass    * ms.impulseAccum;
     rb.angularVelocity += rb.invInertia * cross2(ms.rArm, ms.impulseAccum);
   }
+
+  std::vector<entt::entity> m_candidates;
 };
@@ -0,0 +1,109 @@
+#pragma once
+#include "../physicsSystem.hpp"
+#include "../aabb.hpp"
+#include "../contact.hpp"
+#include "../entityIndex.hpp"
+#include "../unionFind.hpp"
+#include "components/transform.hpp"
+#include "components/physics_components.hpp"
+#include <glm/glm.hpp>
+#include <entt/entt.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Puts islands of resting bodies to sleep. Add it after the solver: a body
+// counts as resting while its speeds stay under the tolerances, and once
+// every dynamic body joined to it through contacts has rested for
+// timeToSleep, the whole island sleeps. Statics and kinematic bodies do not
+// join islands, so a floor does not tie everything on it together; a moving
+// kinematic body keeps whatever it touches awake.
+//
+// Sleeping bodies are skipped by gravity and the solver and keep their
+// contacts as they were. CollisionDetectionSystem wakes an island when
+// something touches it, a contact goes away or one of its bodies is moved;
+// forces, the mouse grab and the Lua setters wake the body they act on.
+class SleepSystem : public PhysicsSystem {
+public:
+  float linearTolerance  = 0.01f;   // m/s
+  float angularTolerance = 0.035f;  // rad/s, about 2 degrees
+  float timeToSleep      = 0.5f;    // s
+
+  void fixedUpdate(entt::registry& reg, float dt) override {
+    const float linSq = linearTolerance * linearTolerance;
+    const float angSq = angularTolerance * angularTolerance;
+
+    m_bodies.clear();
+    m_lookup.clear();
+    auto view = reg.view<RigidBody2D>();
+    for (auto [e, rb] : view.each()) {
+      if (!isDynamic(rb) || isAsleep(rb)) continue;
+      if (glm::dot(rb.velocity, rb.velocity) > linSq ||
+          rb.angularVelocity * rb.angularVelocity > angSq)
+        rb.sleepTime = 0.f;
+      else
+        rb.sleepTime += dt;
+      m_lookup.insert(e, static_cast<uint32_t>(m_bodies.size()));
+      m_bodies.push_back({ e, &rb });
+    }
+    if (m_bodies.empty()) return;
+
+    m_islands.reset(static_cast<uint32_t>(m_bodies.size()));
+
+    if (const auto* cm = reg.ctx().find<ContactManager>()) {
+      for (const ContactConstraint& cc : *cm) {
+        const uint32_t a = m_lookup.find(cc.bodyA), b = m_lookup.find(cc.bodyB);
+        if (a != kNone && b != kNone) {
+          m_islands.unite(a, b);
+          continue;
+        }
+        // Only one side is an awake dynamic body; a moving kinematic
+        // partner keeps it from resting.
+        const uint32_t i = a != kNone ? a : b;
+        if (i == kNone) continue;
+        const auto* other = reg.try_get<RigidBody2D>(a != kNone ? cc.bodyB : cc.bodyA);
+        if (other && isKinematic(*other) &&
+            (other->velocity != glm::vec2(0.f) || other->angularVelocity != 0.f))
+          m_bodies[i].rb->sleepTime = 0.f;
+      }
+    }
+
+    m_minTime.assign(m_bodies.size(), std::numeric_limits<float>::max());
+    for (uint32_t i = 0; i < m_bodies.size(); ++i) {
+      float& t = m_minTime[m_islands.find(i)];
+      t = std::min(t, m_bodies[i].rb->sleepTime);
+    }
+    for (uint32_t i = 0; i < m_bodies.size(); ++i) {
+      if (m_minTime[m_islands.find(i)] < timeToSleep) continue;
+      sleepBody(*m_bodies[i].rb);
+      settle(reg, m_bodies[i].entity);
+    }
+  }
+
+  const char* name() const override { return "Sleep"; }
+
+private:
+  static constexpr uint32_t kNone = EntityIndex::kNone;
+
+  struct Body {
+    entt::entity entity;
+    RigidBody2D* rb;
+  };
+
+  // Bounds are recorded at the pose the body falls asleep in, after the
+  // solver moved it; the collision pass wakes a sleeping body whose
+  // transform no longer matches them.
+  static void settle(entt::registry& reg, entt::entity e) {
+    auto* world = reg.try_get<WorldAABB>(e);
+    const auto* xf = reg.try_get<TransformComponent>(e);
+    if (!world || !xf) return;
+    world->refresh(*xf, reg.try_get<CircleCollider>(e),
+                   reg.try_get<BoxCollider>(e), reg.try_get<ConvexCollider>(e));
+  }
+
+  std::vector<Body>     m_bodies;
+  EntityIndex           m_lookup;   // this step's awake bodies
+  UnionFind             m_islands;
+  std::vector<float>    m_minTime;
+};
@@ -0,0 +1,111 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+#include <algorithm>
+
+// Fixed set of worker threads for data-parallel physics passes. The calling
+// thread takes part in every parallelFor, so a pool with no workers simply
+// runs the loop inline. Lives in reg.ctx(); emplace one with the thread
+// count you want before PhysicsWorld::init to override the default.
+class ThreadPool {
+public:
+  // Total threads including the caller; 0 picks the hardware concurrency.
+  explicit ThreadPool(unsigned threads = 0) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    m_workers.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; ++i)
+      m_workers.emplace_back([this] { workerLoop(); });
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& t : m_workers) t.join();
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  unsigned size() const { return static_cast<unsigned>(m_workers.size()) + 1; }
+
+  // Calls fn(i) for every i in [0, count) and returns once all calls are
+  // done. Which thread runs which index is unspecified, so fn must only
+  // write state owned by index i.
+  template<typename Fn>
+  void parallelFor(uint32_t count, Fn&& fn) {
+    if (count == 0) return;
+    if (m_workers.empty() || count == 1) {
+      for (uint32_t i = 0; i < count; ++i) fn(i);
+      return;
+    }
+
+    using F = std::remove_reference_t<Fn>;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_job    = const_cast<void*>(static_cast<const void*>(&fn));
+      m_invoke = [](void* f, uint32_t i) { (*static_cast<F*>(f))(i); };
+      m_count  = count;
+      m_next.store(0, std::memory_order_relaxed);
+      m_pending = static_cast<unsigned>(m_workers.size());
+      ++m_generation;
+    }
+    m_wake.notify_all();
+
+    drain(m_job, m_invoke, count);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pending == 0; });
+  }
+
+private:
+  using Invoke = void (*)(void*, uint32_t);
+
+  void drain(void* job, Invoke invoke, uint32_t count) {
+    for (uint32_t i = m_next.fetch_add(1, std::memory_order_relaxed); i < count;
+         i = m_next.fetch_add(1, std::memory_order_relaxed))
+      invoke(job, i);
+  }
+
+  void workerLoop() {
+    uint64_t seen = 0;
+    for (;;) {
+      void*    job;
+      Invoke   invoke;
+      uint32_t count;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+        if (m_stop) return;
+        seen   = m_generation;
+        job    = m_job;
+        invoke = m_invoke;
+        count  = m_count;
+      }
+      drain(job, invoke, count);
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pending == 0) m_done.notify_one();
+      }
+    }
+  }
+
+  std::vector<std::thread> m_workers;
+  std::mutex               m_mutex;
+  std::condition_variable  m_wake;
+  std::condition_variable  m_done;
+  void*                    m_job    = nullptr;
+  Invoke                   m_invoke = nullptr;
+  uint32_t                 m_count  = 0;
+  std::atomic<uint32_t>    m_next{ 0 };
+  unsigned                 m_pending    = 0;
+  uint64_t                 m_generation = 0;
+  bool                     m_stop       = false;
+};
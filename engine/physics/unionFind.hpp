@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Disjoint sets over dense indices with path halving. reset() keeps the
+// storage, so the islands can be rebuilt every step without allocating.
+class UnionFind {
+public:
+  void reset(uint32_t count) {
+    m_parent.resize(count);
+    for (uint32_t i = 0; i < count; ++i) m_parent[i] = i;
+  }
+
+  uint32_t find(uint32_t i) {
+    while (m_parent[i] != i) {
+      m_parent[i] = m_parent[m_parent[i]];
+      i = m_parent[i];
+    }
+    return i;
+  }
+
+  void unite(uint32_t a, uint32_t b) {
+    m_parent[find(a)] = find(b);
+  }
+
+private:
+  std::vector<uint32_t> m_parent;
+};
@@ -110,6 +110,17 @@ void RendererSystem::imguiEndFrame() {
 }
 
 
+// Outline points drawn for a convex collider: its vertices, or an arc per
+// corner when the shape is rounded. 0 if there is nothing to draw.
+static uint32_t convexOutlineCount(const ConvexCollider* convex,
+                                   uint32_t cornerSegments) {
+  if (!convex || !convex->shape) return 0;
+  const ConvexShape& shape = *convex->shape;
+  if (shape.rounding > 0.0f)
+    return shape.count >= 2 ? shape.count * (cornerSegments + 1) : 0;
+  return shape.count >= 3 ? shape.count : 0;
+}
+
 void RendererSystem::renderSprites(entt::registry& reg,
                                     const glm::mat4& viewProj) {
   auto spriteView = reg.view<TransformComponent, SpriteComponent>();
@@ -122,7 +133,7 @@ void RendererSystem::renderSprites(entt::registry& reg,
     const SpriteComponent*    sp;
     ShapeType                 shape;
     float                     circleRadius;
-    const std::vector<glm::vec2>* convexVerts;
+    const ConvexCollider*     convex;
   };
 
   std::vector<DrawCmd> drawList;
@@ -133,14 +144,14 @@ void RendererSystem::renderSprites(entt::registry& reg,
     cmd.tf          = &spriteView.get<TransformComponent>(e);
     cmd.sp          = &spriteView.get<SpriteComponent>(e);
     cmd.circleRadius = 0.0f;
-    cmd.convexVerts  = nullptr;
+    cmd.convex       = nullptr;
 
     if (auto* cc = reg.try_get<CircleCollider>(e)) {
       cmd.shape        = ShapeType::Circle;
       cmd.circleRadius = cc->radius;
     } else if (auto* pc = reg.try_get<ConvexCollider>(e)) {
       cmd.shape       = ShapeType::Convex;
-      cmd.convexVerts = &pc->vertices;
+      cmd.convex      = pc;
     } else {
       cmd.shape = ShapeType::Box;
     }
@@ -163,8 +174,7 @@ void RendererSystem::renderSprites(entt::registry& reg,
         totalIndices += kCircleSegments * 3;  
         break;
       case ShapeType::Convex:
-        if (cmd.convexVerts && cmd.convexVerts->size() >= 3) {
-          uint32_t n = static_cast<uint32_t>(cmd.convexVerts->size());
+        if (uint32_t n = convexOutlineCount(cmd.convex, kCornerSegments)) {
           totalVerts   += n + 1;             
           totalIndices += n * 3;           
         }
@@ -257,22 +267,37 @@ void RendererSystem::renderSprites(entt::registry& reg,
       }
 
       case ShapeType::Convex: {
-        const auto& pts = *drawCmd.convexVerts;
-        uint32_t n = static_cast<uint32_t>(pts.size());
-        if (n < 3) break;
+        uint32_t n = convexOutlineCount(drawCmd.convex, kCornerSegments);
+        if (n == 0) break;
+        const ConvexShape& shape = *drawCmd.convex->shape;
+        const glm::vec2* pts = shape.vertices;
 
         uint16_t centreIdx = static_cast<uint16_t>(vi);
 
-        glm::vec2 centroid{0.0f};
-        for (const auto& p : pts) centroid += p;
-        centroid /= static_cast<float>(n);
+        const glm::vec2& centroid = shape.centroid;
 
         verts[vi++] = xform(centroid.x * tf.scale.x,
                             centroid.y * tf.scale.y);
 
-        for (uint32_t s = 0; s < n; ++s) {
-          verts[vi++] = xform(pts[s].x * tf.scale.x,
-                              pts[s].y * tf.scale.y);
+        for (uint32_t s = 0; s < shape.count; ++s) {
+          if (shape.rounding <= 0.0f) {
+            verts[vi++] = xform(pts[s].x * tf.scale.x,
+                                pts[s].y * tf.scale.y);
+            continue;
+          }
+          // Rounded corner: arc from the previous edge's normal to this one's.
+          const glm::vec2& n0 = shape.normals[(s + shape.count - 1) % shape.count];
+          const glm::vec2& n1 = shape.normals[s];
+          float a0    = std::atan2(n0.y, n0.x);
+          float sweep = std::atan2(n1.y, n1.x) - a0;
+          if (sweep < 0.0f) sweep += 2.0f * 3.14159265f;
+          for (uint32_t k = 0; k <= kCornerSegments; ++k) {
+            float angle = a0 + sweep * static_cast<float>(k)
+                          / static_cast<float>(kCornerSegments);
+            glm::vec2 q = pts[s] + shape.rounding * glm::vec2{ std::cos(angle),
+                                                               std::sin(angle) };
+            verts[vi++] = xform(q.x * tf.scale.x, q.y * tf.scale.y);
+          }
         }
 
         for (uint32_t s = 0; s < n; ++s) {
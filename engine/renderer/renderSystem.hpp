@@ -37,4 +37,5 @@ private:
   static constexpr uint32_t kVertsPerSprite  = 4;
   static constexpr uint32_t kIndicesPerSprite = 6;
   static constexpr uint32_t kCircleSegments  = 32;
+  static constexpr uint32_t kCornerSegments  = 6;
 };
\ No newline at end of file
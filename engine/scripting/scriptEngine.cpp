@@ -5,6 +5,10 @@
 #include "Input/input.hpp"
 #include "physics/inertia.hpp"
 #include "physics/collisionEvents.hpp"
+#include "physics/broadphase.hpp"
+#include "physics/query.hpp"
+#include "physics/rayBatch.hpp"
+#include "physics/shapeRegistry.hpp"
 #include "logger/logger.hpp"
 
 #include <glm/glm.hpp>
@@ -138,6 +142,13 @@ void ScriptEngine::bindComponents() {
     "Dynamic",   BodyType::Dynamic
   );
 
+  m_lua.new_enum("BroadphaseMode",
+    "SortAndSweep",     BroadphaseMode::SortAndSweep,
+    "DynamicTree",      BroadphaseMode::DynamicTree,
+    "SpatialHash",      BroadphaseMode::SpatialHash,
+    "IncrementalSweep", BroadphaseMode::IncrementalSweep
+  );
+
   m_lua.new_usertype<CollisionFilter>("CollisionFilter",
     "category_bits", &CollisionFilter::categoryBits,
     "mask_bits",     &CollisionFilter::maskBits,
@@ -164,7 +175,14 @@ void ScriptEngine::bindComponents() {
       [](RigidBody2D& rb, bool s) { setBodyStatic(rb, s); }
     ),
     "fixed_rotation", &RigidBody2D::fixedRotation,
+    "bullet",           &RigidBody2D::bullet,
+    "max_linear_speed", &RigidBody2D::maxLinearSpeed,
     "filter", &RigidBody2D::filter,
+    "awake", sol::property(
+      [](const RigidBody2D& rb) { return !isAsleep(rb); },
+      [](RigidBody2D& rb, bool a) { if (a) wakeBody(rb); else sleepBody(rb); }
+    ),
+    "wake", [](RigidBody2D& rb) { wakeBody(rb); },
     "add_force", [](RigidBody2D& rb, float fx, float fy) {
       addForce(rb, {fx, fy});
     },
@@ -272,10 +290,13 @@ void ScriptEngine::bindECS() {
       if (t["linear_damping"].valid())  rb.linearDamping  = t["linear_damping"];
       if (t["angular_damping"].valid()) rb.angularDamping = t["angular_damping"];
       if (t["fixed_rotation"].valid())  rb.fixedRotation  = t["fixed_rotation"];
+      if (t["bullet"].valid())          rb.bullet         = t["bullet"];
+      if (t["max_linear_speed"].valid()) rb.maxLinearSpeed = t["max_linear_speed"];
       if (t["category_bits"].valid())   rb.filter.categoryBits = t["category_bits"];
       if (t["mask_bits"].valid())       rb.filter.maskBits     = t["mask_bits"];
       if (t["group_index"].valid())     rb.filter.groupIndex   = t["group_index"];
       computeBodyInertia(m_scene->getRegistry(), static_cast<entt::entity>(e));
+      wakeBody(rb);
     },
 
     "circle_collider", [](Entity& e) -> CircleCollider& {
@@ -287,6 +308,7 @@ void ScriptEngine::bindECS() {
       if (!e.hasComponent<CircleCollider>())
         e.addComponent<CircleCollider>();
       e.getComponent<CircleCollider>().radius = radius;
+      invalidateBroadphaseProxy(m_scene->getRegistry(), static_cast<entt::entity>(e));
       computeBodyInertia(m_scene->getRegistry(), static_cast<entt::entity>(e));
     },
 
@@ -299,34 +321,50 @@ void ScriptEngine::bindECS() {
       if (!e.hasComponent<BoxCollider>())
         e.addComponent<BoxCollider>();
       e.getComponent<BoxCollider>().halfExtents = {hw, hh};
+      invalidateBroadphaseProxy(m_scene->getRegistry(), static_cast<entt::entity>(e));
       computeBodyInertia(m_scene->getRegistry(), static_cast<entt::entity>(e));
     },
 
-    "set_polygon_collider", [this](Entity& e, sol::table verts) {
+    "set_polygon_collider", [this](Entity& e, sol::table verts,
+                                   sol::optional<float> rounding) {
       if (!e.hasComponent<ConvexCollider>())
         e.addComponent<ConvexCollider>();
-      auto& cv = e.getComponent<ConvexCollider>();
-      cv.vertices.clear();
+      std::vector<glm::vec2> points;
+      points.reserve(verts.size());
       for (size_t i = 1; i <= verts.size(); ++i) {
         sol::table v = verts[i];
-        cv.vertices.push_back({v[1].get<float>(), v[2].get<float>()});
+        points.push_back({v[1].get<float>(), v[2].get<float>()});
       }
-      cv.ensureCCW();
+      e.getComponent<ConvexCollider>().shape =
+        internConvexShape(m_scene->getRegistry(), points, rounding.value_or(0.0f));
+      invalidateBroadphaseProxy(m_scene->getRegistry(), static_cast<entt::entity>(e));
       computeBodyInertia(m_scene->getRegistry(), static_cast<entt::entity>(e));
     },
 
-    "set_regular_polygon", [this](Entity& e, int sides, float radius) {
+    "set_regular_polygon", [this](Entity& e, int sides, float radius,
+                                  sol::optional<float> rounding) {
       if (sides < 3) sides = 3;
       if (!e.hasComponent<ConvexCollider>())
         e.addComponent<ConvexCollider>();
-      auto& cv = e.getComponent<ConvexCollider>();
-      cv.vertices.clear();
+      std::vector<glm::vec2> points;
+      points.reserve(sides);
       for (int i = 0; i < sides; ++i) {
         float angle = 2.0f * 3.14159265f * static_cast<float>(i) / static_cast<float>(sides)
                     - 3.14159265f / 2.0f; 
-        cv.vertices.push_back({radius * std::cos(angle), radius * std::sin(angle)});
+        points.push_back({radius * std::cos(angle), radius * std::sin(angle)});
       }
-      cv.ensureCCW();
+      e.getComponent<ConvexCollider>().shape =
+        internConvexShape(m_scene->getRegistry(), points, rounding.value_or(0.0f));
+      invalidateBroadphaseProxy(m_scene->getRegistry(), static_cast<entt::entity>(e));
+      computeBodyInertia(m_scene->getRegistry(), static_cast<entt::entity>(e));
+    },
+
+    "set_capsule_collider", [this](Entity& e, float halfLength, float radius) {
+      if (!e.hasComponent<ConvexCollider>())
+        e.addComponent<ConvexCollider>();
+      e.getComponent<ConvexCollider>().shape =
+        internCapsuleShape(m_scene->getRegistry(), halfLength, radius);
+      invalidateBroadphaseProxy(m_scene->getRegistry(), static_cast<entt::entity>(e));
       computeBodyInertia(m_scene->getRegistry(), static_cast<entt::entity>(e));
     },
 
@@ -341,7 +379,9 @@ void ScriptEngine::bindECS() {
     "set_velocity", [](Entity& e, float vx, float vy) {
       if (!e.hasComponent<RigidBody2D>())
         e.addComponent<RigidBody2D>();
-      e.getComponent<RigidBody2D>().velocity = {vx, vy};
+      auto& rb = e.getComponent<RigidBody2D>();
+      rb.velocity = {vx, vy};
+      wakeBody(rb);
     },
     "get_velocity", [](Entity& e) -> glm::vec2 {
       return e.hasComponent<RigidBody2D>()
@@ -390,6 +430,102 @@ void ScriptEngine::bindECS() {
       s.getRegistry().destroy(static_cast<entt::entity>(e));
     },
 
+    "query_aabb", [this](Scene& s, float minX, float minY, float maxX, float maxY,
+                         sol::optional<CollisionFilter> filter) -> sol::table {
+      std::vector<entt::entity> found;
+      queryAABB(s.getRegistry(), AABB{ { minX, minY }, { maxX, maxY } },
+                filter.value_or(CollisionFilter{}), found);
+      sol::table result = m_lua.create_table();
+      int i = 1;
+      for (auto e : found) result[i++] = Entity(e, &s);
+      return result;
+    },
+
+    "query_point", [this](Scene& s, float x, float y,
+                          sol::optional<CollisionFilter> filter) -> sol::table {
+      std::vector<entt::entity> found;
+      queryPoint(s.getRegistry(), { x, y }, filter.value_or(CollisionFilter{}), found);
+      sol::table result = m_lua.create_table();
+      int i = 1;
+      for (auto e : found) result[i++] = Entity(e, &s);
+      return result;
+    },
+
+    "ray_cast", [this](Scene& s, float x1, float y1, float x2, float y2,
+                       sol::optional<CollisionFilter> filter) -> sol::object {
+      RayHit hit;
+      if (!rayCastClosest(s.getRegistry(), { x1, y1 }, { x2, y2 },
+                          filter.value_or(CollisionFilter{}), hit))
+        return sol::lua_nil;
+      sol::table entry = m_lua.create_table();
+      entry["entity"]   = Entity(hit.entity, &s);
+      entry["point"]    = hit.point;
+      entry["normal"]   = hit.normal;
+      entry["fraction"] = hit.fraction;
+      return entry;
+    },
+
+    "ray_cast_all", [this](Scene& s, float x1, float y1, float x2, float y2,
+                           sol::optional<CollisionFilter> filter) -> sol::table {
+      std::vector<RayHit> hits;
+      rayCastAll(s.getRegistry(), { x1, y1 }, { x2, y2 },
+                 filter.value_or(CollisionFilter{}), hits);
+      sol::table result = m_lua.create_table();
+      int i = 1;
+      for (auto& hit : hits) {
+        sol::table entry = m_lua.create_table();
+        entry["entity"]   = Entity(hit.entity, &s);
+        entry["point"]    = hit.point;
+        entry["normal"]   = hit.normal;
+        entry["fraction"] = hit.fraction;
+        result[i++] = entry;
+      }
+      return result;
+    },
+
+    "ray_cast_batch", [this](Scene& s, sol::table rays,
+                             sol::optional<CollisionFilter> filter) -> sol::table {
+      std::vector<RayInput> inputs;
+      inputs.reserve(rays.size());
+      for (size_t i = 1; i <= rays.size(); ++i) {
+        sol::table r = rays[i];
+        RayInput in;
+        in.origin      = r.get_or("origin", glm::vec2{ 0.f });
+        in.direction   = r.get_or("direction", glm::vec2{ 1.f, 0.f });
+        in.maxDistance = r.get_or("max_distance", 1.f);
+        inputs.push_back(in);
+      }
+
+      std::vector<RayHit> hits;
+      rayCastBatch(s.getRegistry(), inputs, filter.value_or(CollisionFilter{}), hits);
+
+      sol::table result = m_lua.create_table(static_cast<int>(hits.size()), 0);
+      for (size_t i = 0; i < hits.size(); ++i) {
+        const RayHit& hit = hits[i];
+        if (hit.entity == entt::null) {
+          result[i + 1] = false;
+          continue;
+        }
+        sol::table entry = m_lua.create_table();
+        entry["entity"]   = Entity(hit.entity, &s);
+        entry["point"]    = hit.point;
+        entry["normal"]   = hit.normal;
+        entry["distance"] = hit.fraction * inputs[i].maxDistance;
+        result[i + 1] = entry;
+      }
+      return result;
+    },
+
+    "set_broadphase", [](Scene& s, BroadphaseMode mode, sol::optional<float> cellSize) {
+      auto& reg = s.getRegistry();
+      if (!reg.ctx().contains<Broadphase>())
+        reg.ctx().emplace<Broadphase>();
+      auto& bp = reg.ctx().get<Broadphase>();
+      bp.mode = mode;
+      if (cellSize.has_value() && cellSize.value() > 0.f)
+        bp.cellSize = cellSize.value();
+    },
+
     
     "get_begin_contacts", [this](Scene& s) -> sol::table {
       auto& reg = s.getRegistry();
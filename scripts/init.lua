@@ -95,6 +95,13 @@ function on_init()
   hex:set_rigidbody({ mass = 0.25, restitution = 0.2, friction = 0.6 })
   hex:set_regular_polygon(6, 0.18)
 
+  local pill = scene:create("OrangeCapsule")
+  pill:set_position(-0.2, 2.2)
+  pill:set_rotation(0.4)
+  pill:set_sprite(1.0, 0.55, 0.1, 1.0,  0.4, 0.16)
+  pill:set_rigidbody({ mass = 0.15, restitution = 0.2, friction = 0.5 })
+  pill:set_capsule_collider(0.12, 0.08)
+
   for i = 0, 3 do
     local s = scene:create("StackBox" .. i)
     s:set_position(2.2, -1.1 + i * 0.26)
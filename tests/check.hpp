@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdio>
+
+// Minimal checks for the headless tests: a failed CHECK reports and counts,
+// and the test's exit code is the failure count.
+inline int g_failures = 0;
+
+#define CHECK(cond)                                                        \
+  do {                                                                     \
+    if (!(cond)) {                                                         \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                   #cond);                                                 \
+      ++g_failures;                                                        \
+    }                                                                      \
+  } while (0)
+
+inline int testResult() {
+  if (g_failures) std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+  return g_failures ? 1 : 0;
+}
@@ -0,0 +1,101 @@
+#include "check.hpp"
+#include "physics/narrowphase.hpp"
+#include <cmath>
+#include <random>
+#include <vector>
+
+using narrowphase::WorldPoly;
+using narrowphase::detail::coreDistance;
+
+namespace {
+
+float segmentDistance2(glm::vec2 p, glm::vec2 a, glm::vec2 b) {
+  const glm::vec2 e = b - a;
+  const float len2 = glm::dot(e, e);
+  const float t = len2 > 0.f ? glm::clamp(glm::dot(p - a, e) / len2, 0.f, 1.f) : 0.f;
+  const glm::vec2 q = p - (a + t * e);
+  return glm::dot(q, q);
+}
+
+float boundaryDistance(const WorldPoly& A, const WorldPoly& B) {
+  float best = 1e30f;
+  for (int i = 0; i < A.count; ++i)
+    for (int j = 0; j < B.count; ++j) {
+      best = std::min(best, segmentDistance2(A.v[i], B.v[j], B.v[(j + 1) % B.count]));
+      best = std::min(best, segmentDistance2(B.v[j], A.v[i], A.v[(i + 1) % A.count]));
+    }
+  return std::sqrt(best);
+}
+
+// Largest gap along A's edge normals; the hulls are counter-clockwise.
+float separation(const WorldPoly& A, const WorldPoly& B) {
+  float best = -1e30f;
+  for (int i = 0; i < A.count; ++i) {
+    const glm::vec2 e = A.v[(i + 1) % A.count] - A.v[i];
+    const float len = glm::length(e);
+    if (len < 1e-6f) continue;
+    const glm::vec2 n{ e.y / len, -e.x / len };
+    float gap = 1e30f;
+    for (int j = 0; j < B.count; ++j)
+      gap = std::min(gap, glm::dot(B.v[j] - A.v[i], n));
+    best = std::max(best, gap);
+  }
+  return best;
+}
+
+// Flat arcs with repeated angles: long runs of nearly collinear and
+// coincident vertices, where GJK makes the least progress per iteration.
+WorldPoly sliver(std::mt19937& rng, glm::vec2 center, float rotation) {
+  std::uniform_real_distribution<float> u(0.f, 1.f);
+  const int n = 3 + static_cast<int>(rng() % 60);
+  std::vector<float> angles(n);
+  for (float& a : angles) a = u(rng) * 6.2831853f;
+  for (int i = 1; i < n; i += 4) angles[i] = angles[i - 1];
+  std::sort(angles.begin(), angles.end());
+
+  const float rx = 0.2f + u(rng), ry = 1e-4f + u(rng) * 1e-3f;
+  const float c = std::cos(rotation), s = std::sin(rotation);
+  WorldPoly p;
+  p.count = n;
+  p.v.resize(n);
+  p.n.resize(n);
+  for (int i = 0; i < n; ++i) {
+    const glm::vec2 local{ rx * std::cos(angles[i]), ry * std::sin(angles[i]) };
+    p.v[i] = center + glm::vec2{ c * local.x - s * local.y, s * local.x + c * local.y };
+  }
+  return p;
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> u(0.f, 1.f);
+
+  for (int trial = 0; trial < 2000; ++trial) {
+    const WorldPoly A = sliver(rng, { 0.f, 0.f }, u(rng) * 3.1415927f);
+    const WorldPoly B = sliver(rng, { u(rng) * 2.f - 1.f, u(rng) * 0.2f - 0.1f },
+                               u(rng) * 3.1415927f);
+    const float exact    = boundaryDistance(A, B);
+    const bool  apart    = std::max(separation(A, B), separation(B, A)) > 1e-5f;
+
+    // Every cap, from one iteration up: a result cut short must still be a
+    // pair of points on the hulls, and overlap must be real.
+    for (int cap = 1; cap <= 33; ++cap) {
+      const auto cd = coreDistance(A, B, cap);
+      if (cd.overlap) {
+        CHECK(!apart);
+        continue;
+      }
+      CHECK(std::isfinite(cd.pointA.x) && std::isfinite(cd.pointA.y));
+      CHECK(std::isfinite(cd.pointB.x) && std::isfinite(cd.pointB.y));
+      CHECK(std::abs(cd.distance - glm::length(cd.pointB - cd.pointA)) < 1e-5f);
+      if (apart) CHECK(cd.distance >= exact - 1e-4f);
+    }
+
+    const auto cd = coreDistance(A, B);
+    if (apart && !cd.overlap) CHECK(std::abs(cd.distance - exact) < 1e-3f);
+  }
+
+  return testResult();
+}